@@ -0,0 +1,76 @@
+#include "bench_common.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Global allocator replacement counting every allocation. Only linked into
+// the benchmark and allocation test executables, never into the library.
+
+namespace {
+
+    std::atomic<std::uint64_t> allocations{ 0 };
+
+    void* allocate(std::size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        if (void* data = std::malloc(size ? size : 1)) {
+            return data;
+        }
+        throw std::bad_alloc();
+    }
+
+    void* allocate_aligned(std::size_t size, std::align_val_t align) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        std::size_t alignment = static_cast<std::size_t>(align);
+        size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+        void* data = _aligned_malloc(size ? size : alignment, alignment);
+#else
+        void* data = std::aligned_alloc(alignment, size ? size : alignment);
+#endif
+        if (!data) {
+            throw std::bad_alloc();
+        }
+        return data;
+    }
+
+    void release_aligned(void* data) noexcept {
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        std::free(data);
+#endif
+    }
+
+} // namespace
+
+namespace RPFL::Bench {
+
+    std::uint64_t allocation_count() noexcept {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+} // namespace RPFL::Bench
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+
+void operator delete(void* data) noexcept { std::free(data); }
+void operator delete[](void* data) noexcept { std::free(data); }
+void operator delete(void* data, std::size_t) noexcept { std::free(data); }
+void operator delete[](void* data, std::size_t) noexcept { std::free(data); }
+void operator delete(void* data, std::align_val_t) noexcept { release_aligned(data); }
+void operator delete[](void* data, std::align_val_t) noexcept { release_aligned(data); }
+void operator delete(void* data, std::size_t, std::align_val_t) noexcept { release_aligned(data); }
+void operator delete[](void* data, std::size_t, std::align_val_t) noexcept { release_aligned(data); }
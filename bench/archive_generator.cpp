@@ -0,0 +1,165 @@
+#include "archive_generator.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <numbers>
+#include <stdexcept>
+
+namespace RPFL::Bench {
+
+    namespace {
+
+        constexpr std::size_t kFillChunk = 64 * 1024;
+
+        std::uint64_t entry_seed(std::uint64_t seed, std::uint64_t index) noexcept {
+            SplitMix64 mix(seed ^ (index * 0xD1B54A32D192ED03ull));
+            return mix.next();
+        }
+
+        // Box-Muller, one normal sample per call is plenty here
+        double normal(SplitMix64& random) noexcept {
+            double u1 = std::max(random.uniform(), 1e-300);
+            double u2 = random.uniform();
+            return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * std::numbers::pi * u2);
+        }
+
+        std::uint32_t pick_alignment(SplitMix64& random,
+            const std::vector<std::pair<std::uint32_t, unsigned>>& mix, unsigned total_weight) {
+            if (total_weight == 0) {
+                return 1;
+            }
+            auto pick = static_cast<unsigned>(random.next() % total_weight);
+            for (const auto& [align, weight] : mix) {
+                if (pick < weight) {
+                    return align;
+                }
+                pick -= weight;
+            }
+            return 1;
+        }
+
+        ArchiveWriter::EntrySource entry_data(std::uint64_t seed, std::uint64_t size) {
+            return [seed, size](const ArchiveWriter::ChunkSink& sink) {
+                SplitMix64 random(seed);
+                std::vector<std::byte> buffer(static_cast<std::size_t>(std::min<std::uint64_t>(size, kFillChunk)));
+                for (std::uint64_t left = size; left > 0;) {
+                    std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(left, buffer.size()));
+                    for (std::size_t i = 0; i < n; i += sizeof(std::uint64_t)) {
+                        std::uint64_t word = random.next();
+                        std::memcpy(buffer.data() + i, &word, std::min(sizeof(word), n - i));
+                    }
+                    sink(std::span<const std::byte>(buffer.data(), n));
+                    left -= n;
+                }
+            };
+        }
+
+    } // namespace
+
+    GeneratorStats add_generated_entries(ArchiveWriter& writer, const GeneratorConfig& config) {
+        GeneratorStats stats;
+        SplitMix64 random(config.seed);
+        unsigned total_weight = 0;
+        for (const auto& [align, weight] : config.alignments) {
+            total_weight += weight;
+        }
+
+        const unsigned min_depth = std::min(config.min_depth, config.max_depth);
+        const unsigned fanout = std::max(config.fanout, 1u);
+        const double mu = std::log(static_cast<double>(std::max<std::uint64_t>(config.median_size, 1)));
+
+        std::uint64_t next_blob = 0;
+        std::string path;
+        for (std::uint64_t index = 0; index < config.entries; ++index) {
+            // Blobs sit at evenly spaced positions
+            bool blob = next_blob < config.blob_count
+                && index == (next_blob + 1) * config.entries / (config.blob_count + 1);
+
+            unsigned depth = min_depth + static_cast<unsigned>(random.next() % (config.max_depth - min_depth + 1));
+            path.clear();
+            for (unsigned level = 0; level < depth; ++level) {
+                path += std::format("d{}_{}/", level, random.next() % fanout);
+            }
+
+            std::uint64_t size;
+            if (blob) {
+                path += std::format("blob{:x}.bin", index);
+                size = config.blob_size;
+                ++next_blob;
+            }
+            else {
+                path += std::format("f{:x}.bin", index);
+                double sample = std::exp(mu + config.size_sigma * normal(random));
+                size = std::min<std::uint64_t>(static_cast<std::uint64_t>(sample), config.max_size);
+            }
+            std::uint32_t align = pick_alignment(random, config.alignments, total_weight);
+
+            writer.add_file_source(path, size, entry_data(entry_seed(config.seed, index), size), align);
+            ++stats.entries;
+            stats.data_bytes += size;
+        }
+        return stats;
+    }
+
+    GeneratorStats generate_archive(const GeneratorConfig& config, const std::string& filepath) {
+        ArchiveWriter writer;
+        writer.set_endianness(config.endianness);
+        writer.set_manifest_mode(config.manifest_mode);
+        writer.set_output_mode(config.output_mode);
+
+        GeneratorStats stats = add_generated_entries(writer, config);
+        stats.archive_bytes = writer.total_size();
+        if (filepath == "-") {
+            writer.write(1);
+        }
+        else {
+            writer.write(filepath);
+        }
+        return stats;
+    }
+
+    std::vector<std::pair<std::uint32_t, unsigned>> parse_alignment_mix(std::string_view text) {
+        std::vector<std::pair<std::uint32_t, unsigned>> mix;
+        while (!text.empty()) {
+            std::string_view item = text.substr(0, text.find(','));
+            text.remove_prefix(std::min(text.size(), item.size() + 1));
+
+            std::uint32_t align = 1;
+            unsigned weight = 1;
+            auto colon = std::min(item.find(':'), item.size());
+            const char* align_end = item.data() + colon;
+            auto [end, error] = std::from_chars(item.data(), align_end, align);
+            if (error != std::errc() || end != align_end || align == 0 || (align & (align - 1)) != 0) {
+                throw std::invalid_argument(std::format("bad alignment '{}'", item));
+            }
+            if (colon != item.size()) {
+                const char* weight_end = item.data() + item.size();
+                auto [stop, weight_error] = std::from_chars(align_end + 1, weight_end, weight);
+                if (weight_error != std::errc() || stop != weight_end || weight == 0) {
+                    throw std::invalid_argument(std::format("bad weight in '{}'", item));
+                }
+            }
+            mix.emplace_back(align, weight);
+        }
+        return mix;
+    }
+
+    std::uint64_t parse_size(std::string_view text) {
+        std::uint64_t value = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc()) {
+            throw std::invalid_argument(std::format("bad size '{}'", text));
+        }
+        std::string_view suffix(end, text.data() + text.size() - end);
+        if (suffix == "K" || suffix == "k") return value << 10;
+        if (suffix == "M" || suffix == "m") return value << 20;
+        if (suffix == "G" || suffix == "g") return value << 30;
+        if (!suffix.empty()) {
+            throw std::invalid_argument(std::format("bad size '{}'", text));
+        }
+        return value;
+    }
+
+} // namespace RPFL::Bench
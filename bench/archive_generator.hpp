@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "archive_writer.hpp"
+
+// Deterministic synthetic archives for benchmarks and scale tests. The same
+// config always produces the same bytes; entry data is generated while the
+// archive is written, so archives can be far larger than memory.
+
+namespace RPFL::Bench {
+
+    struct GeneratorConfig {
+        std::uint64_t seed = 1;
+        std::uint64_t entries = 10000;
+
+        // Small entries: log-normal sizes around the median, capped
+        std::uint64_t median_size = 4096;
+        double size_sigma = 1.5;
+        std::uint64_t max_size = 16 * 1024 * 1024;
+
+        // A few big blobs spread through the archive
+        std::uint64_t blob_count = 0;
+        std::uint64_t blob_size = 256 * 1024 * 1024;
+
+        // Paths: depth in [min_depth, max_depth] directories, each picked from
+        // `fanout` names per level; a small fanout means long shared prefixes
+        unsigned min_depth = 1;
+        unsigned max_depth = 4;
+        unsigned fanout = 16;
+
+        // Alignment and its weight, picked per entry
+        std::vector<std::pair<std::uint32_t, unsigned>> alignments{ { 1, 1 } };
+
+        Endianness endianness = Endianness::Big;
+        ManifestMode manifest_mode = ManifestMode::None;
+        OutputMode output_mode = OutputMode::Buffered;
+    };
+
+    struct GeneratorStats {
+        std::uint64_t entries = 0;
+        std::uint64_t data_bytes = 0;
+        std::uint64_t archive_bytes = 0;
+    };
+
+    // Small, fast and identical everywhere, unlike the <random> distributions
+    class SplitMix64 {
+    public:
+        explicit SplitMix64(std::uint64_t seed) noexcept : state_(seed) {}
+
+        std::uint64_t next() noexcept {
+            std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [0, 1)
+        double uniform() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    private:
+        std::uint64_t state_;
+    };
+
+    // Adds the generated entries to writer as streamed sources
+    GeneratorStats add_generated_entries(ArchiveWriter& writer, const GeneratorConfig& config);
+
+    // Generates a whole archive at filepath ("-" writes to standard output)
+    GeneratorStats generate_archive(const GeneratorConfig& config, const std::string& filepath);
+
+    // "1:70,16:20,4096:10" -> {{1,70},{16,20},{4096,10}}
+    std::vector<std::pair<std::uint32_t, unsigned>> parse_alignment_mix(std::string_view text);
+
+    // "64", "4K", "16M", "2G"
+    std::uint64_t parse_size(std::string_view text);
+
+} // namespace RPFL::Bench
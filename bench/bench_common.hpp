@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Shared by the rpfl_* benchmark executables. Each one links
+// alloc_counter.cpp, which replaces the global allocator to count calls.
+
+namespace RPFL::Bench {
+
+    // Heap allocations made by the whole process so far
+    std::uint64_t allocation_count() noexcept;
+
+    // Keeps the compiler from dropping a result that is otherwise unused
+    template<typename T>
+    inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    // stem plus a suffix drawn once per process, for scratch files that
+    // parallel runs (ctest -j, several build trees) must not share
+    inline std::string unique_name(std::string_view stem) {
+        static const unsigned suffix = std::random_device{}();
+        return std::string(stem) + '_' + std::to_string(suffix);
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    inline double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    struct Result {
+        std::string name;
+        std::uint64_t iterations = 0;
+        double ns_per_op = 0;
+        double bytes_per_second = 0; // 0 when the operation moves no data
+        double allocations_per_op = 0;
+    };
+
+    struct Settings {
+        double min_seconds = 0.2; // per benchmark, after calibration
+        std::string filter;       // only names containing this
+        std::string json;         // also write the results here, see write_json()
+        unsigned repetitions = 1; // measured batches, the fastest one counts
+    };
+
+    // Runs op(i) for growing iteration counts until one batch takes at least
+    // a tenth of min_seconds, then measures batches sized to min_seconds and
+    // keeps the fastest, which is the least disturbed by the rest of the system
+    template<typename Op>
+    Result measure(std::string name, std::uint64_t bytes_per_op, const Settings& settings, Op&& op) {
+        std::uint64_t iterations = 1;
+        for (;;) {
+            auto start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                op(i);
+            }
+            double elapsed = seconds_since(start);
+            if (elapsed >= settings.min_seconds / 10 || iterations >= (1ull << 40)) {
+                double per_op = elapsed / static_cast<double>(iterations);
+                iterations = std::max<std::uint64_t>(1,
+                    static_cast<std::uint64_t>(settings.min_seconds / std::max(per_op, 1e-12)));
+                break;
+            }
+            iterations *= 2;
+        }
+
+        double elapsed = 0;
+        std::uint64_t allocations = 0;
+        for (unsigned repetition = 0; repetition < std::max(settings.repetitions, 1u); ++repetition) {
+            std::uint64_t batch_allocations = allocation_count();
+            auto start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                op(i);
+            }
+            double batch = seconds_since(start);
+            batch_allocations = allocation_count() - batch_allocations;
+            if (repetition == 0 || batch < elapsed) {
+                elapsed = batch;
+                allocations = batch_allocations;
+            }
+        }
+
+        Result result;
+        result.name = std::move(name);
+        result.iterations = iterations;
+        result.ns_per_op = elapsed * 1e9 / static_cast<double>(iterations);
+        result.bytes_per_second = bytes_per_op > 0
+            ? static_cast<double>(bytes_per_op) * static_cast<double>(iterations) / elapsed : 0;
+        result.allocations_per_op = static_cast<double>(allocations) / static_cast<double>(iterations);
+        return result;
+    }
+
+    // q in [0, 1] of unsorted samples, reorders them
+    inline std::uint64_t percentile(std::vector<std::uint64_t>& samples, double q) {
+        if (samples.empty()) {
+            return 0;
+        }
+        auto index = static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1) + 0.5);
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    inline bool selected(std::string_view name, const Settings& settings) {
+        return settings.filter.empty() || name.find(settings.filter) != std::string_view::npos;
+    }
+
+    inline void print_header() {
+        std::printf("%-32s %12s %14s %12s %12s\n", "benchmark", "iterations", "ns/op", "MB/s", "allocs/op");
+    }
+
+    inline void print(const Result& result) {
+        std::printf("%-32s %12llu %14.1f %12.1f %12.2f\n", result.name.c_str(),
+            static_cast<unsigned long long>(result.iterations), result.ns_per_op,
+            result.bytes_per_second / (1024.0 * 1024.0), result.allocations_per_op);
+        std::fflush(stdout);
+    }
+
+    // {"benchmarks": [{"name": ..., "iterations": ..., "ns_per_op": ...,
+    //   "bytes_per_second": ..., "allocations_per_op": ...}, ...]}
+    // as read by rpfl_bench_compare; false if the file can't be written
+    inline bool write_json(const std::vector<Result>& results, const std::string& filepath) {
+        std::FILE* file = std::fopen(filepath.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        std::fprintf(file, "{\n  \"benchmarks\": [");
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            std::string name;
+            for (char c : result.name) {
+                if (c == '"' || c == '\\') {
+                    name += '\\';
+                }
+                name += c;
+            }
+            std::fprintf(file, "%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, "
+                "\"bytes_per_second\": %.1f, \"allocations_per_op\": %.4f}",
+                i == 0 ? "" : ",", name.c_str(), static_cast<unsigned long long>(result.iterations),
+                result.ns_per_op, result.bytes_per_second, result.allocations_per_op);
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+
+} // namespace RPFL::Bench
@@ -0,0 +1,321 @@
+#include "RPFL.h"
+#include "archive_generator.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// rpfl_bench_cache: first-access latency and throughput with the archive
+// evicted from the page cache (cold) and after a warm-up pass (warm)
+//   --archive PATH     archive to read (default: generated, see --entries)
+//   --dir DIR          where the generated archive goes (default temp dir;
+//                      tmpfs can't be evicted, pick a disk-backed one)
+//   --entries N        entries of the generated archive (default 20000)
+//   --sample N         entries read per run (default 2000)
+//   --batch N          entries per batch in the batched pattern (default 64)
+//   --paths LIST       mmap, mmap+prefetch, pread (default all)
+// Eviction is posix_fadvise(DONTNEED) after fdatasync, so no root is needed;
+// the "resident" column shows how much of the archive it actually dropped.
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+
+    constexpr std::size_t kPage = 4096;
+
+    enum class Path { Mmap, MmapPrefetch, Pread };
+    enum class Pattern { Random, Sequential, Batched };
+
+    constexpr std::string_view path_name(Path path) {
+        switch (path) {
+        case Path::Mmap: return "mmap";
+        case Path::MmapPrefetch: return "mmap+prefetch";
+        case Path::Pread: return "pread";
+        }
+        return "?";
+    }
+
+    constexpr std::string_view pattern_name(Pattern pattern) {
+        switch (pattern) {
+        case Pattern::Random: return "random";
+        case Pattern::Sequential: return "sequential";
+        case Pattern::Batched: return "batched";
+        }
+        return "?";
+    }
+
+    struct Options {
+        std::string archive;
+        std::string dir;
+        std::uint64_t entries = 20000;
+        std::size_t sample = 2000;
+        std::size_t batch = 64;
+        std::vector<Path> paths{ Path::Mmap, Path::MmapPrefetch, Path::Pread };
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string_view flag = argv[i];
+            std::string_view value = argv[i + 1];
+            if (flag == "--archive") options.archive = value;
+            else if (flag == "--dir") options.dir = value;
+            else if (flag == "--entries") options.entries = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--sample") options.sample = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--batch") options.batch = std::max<std::size_t>(1, std::strtoull(value.data(), nullptr, 10));
+            else if (flag == "--paths") {
+                options.paths.clear();
+                while (!value.empty()) {
+                    std::string_view item = value.substr(0, value.find(','));
+                    value.remove_prefix(std::min(value.size(), item.size() + 1));
+                    if (item == "mmap") options.paths.push_back(Path::Mmap);
+                    else if (item == "mmap+prefetch") options.paths.push_back(Path::MmapPrefetch);
+                    else if (item == "pread") options.paths.push_back(Path::Pread);
+                    else {
+                        std::fprintf(stderr, "unknown path %.*s\n", static_cast<int>(item.size()), item.data());
+                        std::exit(2);
+                    }
+                }
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                std::exit(2);
+            }
+        }
+        return options;
+    }
+
+    class FileDescriptor {
+    public:
+        explicit FileDescriptor(const std::string& filepath) : fd_(::open(filepath.c_str(), O_RDONLY)) {
+            if (fd_ == -1) {
+                throw IOError("Failed to open file: " + filepath);
+            }
+        }
+        ~FileDescriptor() { ::close(fd_); }
+        FileDescriptor(const FileDescriptor&) = delete;
+        FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+        int get() const noexcept { return fd_; }
+
+    private:
+        int fd_;
+    };
+
+    // Dirty pages can't be dropped, so flush them first
+    void evict(const std::string& filepath) {
+        FileDescriptor fd(filepath);
+        ::fdatasync(fd.get());
+        if (::posix_fadvise(fd.get(), 0, 0, POSIX_FADV_DONTNEED) != 0) {
+            throw IOError("posix_fadvise failed for " + filepath);
+        }
+    }
+
+    // Fraction of the file's pages in the page cache
+    double resident_fraction(const std::string& filepath) {
+        FileDescriptor fd(filepath);
+        struct stat st;
+        if (::fstat(fd.get(), &st) == -1 || st.st_size == 0) {
+            return 0.0;
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+        if (map == MAP_FAILED) {
+            return 0.0;
+        }
+        std::vector<unsigned char> pages((size + kPage - 1) / kPage);
+        double fraction = 0.0;
+        if (::mincore(map, size, pages.data()) == 0) {
+            auto resident = std::count_if(pages.begin(), pages.end(), [](unsigned char page) { return page & 1; });
+            fraction = static_cast<double>(resident) / static_cast<double>(pages.size());
+        }
+        ::munmap(map, size);
+        return fraction;
+    }
+
+    // One byte per page is enough to fault the whole range in
+    std::uint64_t touch(std::span<const std::byte> data) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < data.size(); i += kPage) {
+            sum += std::to_integer<std::uint8_t>(data[i]);
+        }
+        if (!data.empty()) {
+            sum += std::to_integer<std::uint8_t>(data.back());
+        }
+        return sum;
+    }
+
+    // madvise wants a page-aligned start
+    void advise_willneed(std::span<const std::byte> data) {
+        auto begin = reinterpret_cast<std::uintptr_t>(data.data()) & ~(std::uintptr_t(kPage) - 1);
+        auto end = reinterpret_cast<std::uintptr_t>(data.data() + data.size());
+        if (end > begin) {
+            ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+        }
+    }
+
+    // Entry order for a run, as indices into reader.files()
+    std::vector<std::size_t> access_order(const ArchiveReader& reader, Pattern pattern, std::size_t sample,
+        std::size_t batch, std::uint64_t seed) {
+        const auto& files = reader.files();
+        std::vector<std::size_t> by_offset(files.size());
+        std::iota(by_offset.begin(), by_offset.end(), std::size_t{ 0 });
+        std::sort(by_offset.begin(), by_offset.end(), [&](std::size_t a, std::size_t b) {
+            return files[a]->offset() < files[b]->offset();
+        });
+        sample = std::min(sample, files.size());
+
+        SplitMix64 random(seed);
+        std::vector<std::size_t> order;
+        if (pattern == Pattern::Sequential) {
+            std::size_t first = files.size() > sample ? random.next() % (files.size() - sample) : 0;
+            order.assign(by_offset.begin() + first, by_offset.begin() + first + sample);
+            return order;
+        }
+
+        // Partial Fisher-Yates, the first `sample` slots are the pick
+        std::vector<std::size_t> all(files.size());
+        std::iota(all.begin(), all.end(), std::size_t{ 0 });
+        for (std::size_t i = 0; i < sample; ++i) {
+            std::swap(all[i], all[i + random.next() % (all.size() - i)]);
+        }
+        order.assign(all.begin(), all.begin() + sample);
+        if (pattern == Pattern::Batched) {
+            for (std::size_t i = 0; i < order.size(); i += batch) {
+                auto last = order.begin() + std::min(order.size(), i + batch);
+                std::sort(order.begin() + i, last, [&](std::size_t a, std::size_t b) {
+                    return files[a]->offset() < files[b]->offset();
+                });
+            }
+        }
+        return order;
+    }
+
+    struct RunResult {
+        double open_seconds = 0;
+        double seconds = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p99 = 0;
+        std::uint64_t max = 0;
+        double resident = 0; // before the run
+    };
+
+    RunResult run(const std::string& archive, const Options& options, Path path, Pattern pattern, bool cold) {
+        if (cold) {
+            evict(archive);
+        }
+        RunResult result;
+        result.resident = resident_fraction(archive);
+
+        MemoryMappedFile::Options mmap_options;
+        mmap_options.prefetch = path == Path::MmapPrefetch;
+        auto start = Clock::now();
+        ArchiveReader reader(archive, 1024 * 1024, true, true, mmap_options);
+        std::unique_ptr<FileDescriptor> fd;
+        if (path == Path::Pread) {
+            fd = std::make_unique<FileDescriptor>(archive);
+        }
+        result.open_seconds = seconds_since(start);
+
+        const auto& files = reader.files();
+        auto order = access_order(reader, pattern, options.sample, options.batch, 0xCAC4E);
+        std::vector<std::uint64_t> latencies;
+        latencies.reserve(order.size());
+        std::vector<std::byte> buffer;
+
+        start = Clock::now();
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            // Batches announce all their ranges before the first read
+            if (pattern == Pattern::Batched && i % options.batch == 0) {
+                for (std::size_t j = i; j < std::min(order.size(), i + options.batch); ++j) {
+                    const ArchiveFile& file = *files[order[j]];
+                    if (path == Path::Pread) {
+                        ::posix_fadvise(fd->get(), static_cast<off_t>(file.offset()),
+                            static_cast<off_t>(file.size()), POSIX_FADV_WILLNEED);
+                    }
+                    else {
+                        advise_willneed(file.raw_data());
+                    }
+                }
+            }
+
+            const ArchiveFile& file = *files[order[i]];
+            auto entry_start = Clock::now();
+            if (path == Path::Pread) {
+                buffer.resize(static_cast<std::size_t>(file.size()));
+                std::size_t done = 0;
+                while (done < buffer.size()) {
+                    ssize_t n = ::pread(fd->get(), buffer.data() + done, buffer.size() - done,
+                        static_cast<off_t>(file.offset() + done));
+                    if (n <= 0) {
+                        throw IOError("pread failed on " + archive);
+                    }
+                    done += static_cast<std::size_t>(n);
+                }
+                keep(buffer.data());
+            }
+            else {
+                keep(touch(file.raw_data()));
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - entry_start);
+            latencies.push_back(static_cast<std::uint64_t>(elapsed.count()));
+            result.bytes += file.size();
+        }
+        result.seconds = seconds_since(start);
+
+        result.p50 = percentile(latencies, 0.50);
+        result.p99 = percentile(latencies, 0.99);
+        result.max = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+        return result;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = parse_options(argc, argv);
+    bool generated = options.archive.empty();
+    if (generated) {
+        std::filesystem::path dir = options.dir.empty()
+            ? std::filesystem::temp_directory_path() : std::filesystem::path(options.dir);
+        options.archive = (dir / (unique_name("rpfl_bench_cache") + ".gfs")).string();
+        GeneratorConfig config;
+        config.entries = options.entries;
+        generate_archive(config, options.archive);
+    }
+
+    std::printf("%-14s %-11s %-5s %9s %10s %10s %10s %12s %9s\n",
+        "path", "pattern", "cache", "resident", "open us", "MB/s", "p50 ns", "p99 ns", "max us");
+    for (Pattern pattern : { Pattern::Random, Pattern::Sequential, Pattern::Batched }) {
+        for (Path path : options.paths) {
+            for (bool cold : { true, false }) {
+                if (!cold) {
+                    // Warm-up pass, the measured run then finds everything cached
+                    run(options.archive, options, path, pattern, false);
+                }
+                RunResult result = run(options.archive, options, path, pattern, cold);
+                std::printf("%-14.*s %-11.*s %-5s %8.0f%% %10.0f %10.1f %10llu %12llu %9llu\n",
+                    static_cast<int>(path_name(path).size()), path_name(path).data(),
+                    static_cast<int>(pattern_name(pattern).size()), pattern_name(pattern).data(),
+                    cold ? "cold" : "warm", 100.0 * result.resident, result.open_seconds * 1e6,
+                    static_cast<double>(result.bytes) / (1024.0 * 1024.0) / std::max(result.seconds, 1e-9),
+                    static_cast<unsigned long long>(result.p50), static_cast<unsigned long long>(result.p99),
+                    static_cast<unsigned long long>(result.max / 1000));
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (generated) {
+        std::filesystem::remove(options.archive);
+    }
+    return 0;
+}
@@ -0,0 +1,301 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// rpfl_bench_compare: checks benchmark results against a stored baseline
+//   rpfl_bench_compare BASELINE RESULTS [--update]
+// RESULTS is what rpfl_bench --json writes. BASELINE looks like
+//   {"default_tolerance": 0.3,
+//    "benchmarks": [{"name": "open", "ns_per_op": 1500, "tolerance": 0.5,
+//                    "allocations_per_op": 2}, ...]}
+// A benchmark fails when its ns/op exceeds the baseline by more than its
+// tolerance (a fraction, default_tolerance unless given), when it allocates
+// more than the baseline's allocations_per_op (if present), or when a
+// baseline benchmark is missing from the results. Faster results only get
+// reported. --update rewrites the baseline's numbers from RESULTS and keeps
+// the tolerances. Exits 1 on any failure.
+
+namespace {
+
+    // Just enough JSON for the two files above
+    struct Json {
+        enum class Kind { Null, Bool, Number, String, Array, Object };
+        Kind kind = Kind::Null;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<Json> array;
+        std::vector<std::pair<std::string, Json>> object; // in file order
+
+        const Json* find(std::string_view key) const {
+            for (const auto& [name, value] : object) {
+                if (name == key) {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+
+        double number_or(std::string_view key, double fallback) const {
+            const Json* value = find(key);
+            return value && value->kind == Kind::Number ? value->number : fallback;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(std::string_view text) : text_(text) {}
+
+        Json parse() {
+            Json value = parse_value();
+            skip_space();
+            if (position_ != text_.size()) {
+                fail("trailing characters");
+            }
+            return value;
+        }
+
+    private:
+        [[noreturn]] void fail(const char* what) const {
+            throw std::runtime_error(std::string("JSON ") + what + " at offset " + std::to_string(position_));
+        }
+
+        void skip_space() {
+            while (position_ < text_.size() && std::string_view(" \t\r\n").find(text_[position_]) != std::string_view::npos) {
+                ++position_;
+            }
+        }
+
+        bool consume(char c) {
+            skip_space();
+            if (position_ < text_.size() && text_[position_] == c) {
+                ++position_;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c) {
+            if (!consume(c)) {
+                fail("syntax error");
+            }
+        }
+
+        Json parse_value() {
+            skip_space();
+            if (position_ == text_.size()) {
+                fail("unexpected end");
+            }
+            Json value;
+            char c = text_[position_];
+            if (c == '{') {
+                value.kind = Json::Kind::Object;
+                ++position_;
+                if (!consume('}')) {
+                    do {
+                        skip_space();
+                        std::string key = parse_string();
+                        expect(':');
+                        value.object.emplace_back(std::move(key), parse_value());
+                    } while (consume(','));
+                    expect('}');
+                }
+            }
+            else if (c == '[') {
+                value.kind = Json::Kind::Array;
+                ++position_;
+                if (!consume(']')) {
+                    do {
+                        value.array.push_back(parse_value());
+                    } while (consume(','));
+                    expect(']');
+                }
+            }
+            else if (c == '"') {
+                value.kind = Json::Kind::String;
+                value.string = parse_string();
+            }
+            else if (text_.substr(position_, 4) == "true" || text_.substr(position_, 5) == "false") {
+                value.kind = Json::Kind::Bool;
+                value.boolean = c == 't';
+                position_ += value.boolean ? 4 : 5;
+            }
+            else if (text_.substr(position_, 4) == "null") {
+                position_ += 4;
+            }
+            else {
+                value.kind = Json::Kind::Number;
+                std::string number(text_.substr(position_, text_.find_first_of(",]} \t\r\n", position_) - position_));
+                char* end = nullptr;
+                value.number = std::strtod(number.c_str(), &end);
+                if (number.empty() || end != number.c_str() + number.size()) {
+                    fail("bad number");
+                }
+                position_ += number.size();
+            }
+            return value;
+        }
+
+        std::string parse_string() {
+            if (position_ >= text_.size() || text_[position_] != '"') {
+                fail("expected a string");
+            }
+            ++position_;
+            std::string result;
+            while (position_ < text_.size() && text_[position_] != '"') {
+                char c = text_[position_++];
+                if (c == '\\' && position_ < text_.size()) {
+                    c = text_[position_++];
+                    c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+                }
+                result += c;
+            }
+            if (position_ == text_.size()) {
+                fail("unterminated string");
+            }
+            ++position_;
+            return result;
+        }
+
+        std::string_view text_;
+        std::size_t position_ = 0;
+    };
+
+    Json load(const std::string& filepath) {
+        std::ifstream in(filepath, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot read " + filepath);
+        }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        try {
+            return JsonParser(text).parse();
+        }
+        catch (const std::exception& e) {
+            throw std::runtime_error(filepath + ": " + e.what());
+        }
+    }
+
+    const std::vector<Json>& benchmarks(const Json& root, const std::string& filepath) {
+        const Json* list = root.find("benchmarks");
+        if (!list || list->kind != Json::Kind::Array) {
+            throw std::runtime_error(filepath + ": no \"benchmarks\" array");
+        }
+        return list->array;
+    }
+
+    std::string name_of(const Json& benchmark) {
+        const Json* name = benchmark.find("name");
+        return name && name->kind == Json::Kind::String ? name->string : std::string();
+    }
+
+    void write_baseline(const std::string& filepath, double default_tolerance,
+        const std::vector<Json>& baseline, const std::map<std::string, const Json*>& results) {
+        std::ostringstream out;
+        out << "{\n  \"default_tolerance\": " << default_tolerance << ",\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < baseline.size(); ++i) {
+            const Json& entry = baseline[i];
+            std::string name = name_of(entry);
+            auto result = results.find(name);
+            const Json& source = result != results.end() ? *result->second : entry;
+            char line[512];
+            std::snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.1f", i == 0 ? "" : ",",
+                name.c_str(), source.number_or("ns_per_op", 0));
+            out << line;
+            if (const Json* tolerance = entry.find("tolerance")) {
+                out << ", \"tolerance\": " << tolerance->number;
+            }
+            if (entry.find("allocations_per_op")) {
+                std::snprintf(line, sizeof(line), ", \"allocations_per_op\": %g",
+                    std::ceil(source.number_or("allocations_per_op", 0) * 100) / 100);
+                out << line;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        file << out.str();
+        if (!file) {
+            throw std::runtime_error("cannot write " + filepath);
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: rpfl_bench_compare BASELINE RESULTS [--update]\n");
+        return 2;
+    }
+    try {
+        std::string baseline_path = argv[1];
+        std::string results_path = argv[2];
+        bool update = argc > 3 && std::string_view(argv[3]) == "--update";
+
+        Json baseline = load(baseline_path);
+        Json results = load(results_path);
+        double default_tolerance = baseline.number_or("default_tolerance", 0.3);
+
+        std::map<std::string, const Json*> by_name;
+        for (const Json& result : benchmarks(results, results_path)) {
+            by_name[name_of(result)] = &result;
+        }
+
+        if (update) {
+            write_baseline(baseline_path, default_tolerance, benchmarks(baseline, baseline_path), by_name);
+            std::printf("updated %s\n", baseline_path.c_str());
+            return 0;
+        }
+
+        int failures = 0;
+        std::printf("%-32s %14s %14s %9s %10s  %s\n", "benchmark", "baseline ns", "current ns", "change", "tolerance", "status");
+        for (const Json& entry : benchmarks(baseline, baseline_path)) {
+            std::string name = name_of(entry);
+            double tolerance = entry.number_or("tolerance", default_tolerance);
+            auto found = by_name.find(name);
+            if (found == by_name.end()) {
+                std::printf("%-32s %14s %14s %9s %9.0f%%  FAIL (missing)\n", name.c_str(), "", "", "", tolerance * 100);
+                ++failures;
+                continue;
+            }
+            const Json& result = *found->second;
+            double expected = entry.number_or("ns_per_op", 0);
+            double actual = result.number_or("ns_per_op", 0);
+            double change = expected > 0 ? actual / expected - 1 : 0;
+
+            const char* status = "ok";
+            if (change > tolerance) {
+                status = "FAIL (slower)";
+            }
+            else if (change < -tolerance) {
+                status = "ok (faster, consider --update)";
+            }
+            if (const Json* allocations = entry.find("allocations_per_op")) {
+                if (result.number_or("allocations_per_op", 0) > allocations->number + 0.01) {
+                    status = "FAIL (allocates more)";
+                }
+            }
+            failures += status[0] == 'F' ? 1 : 0;
+            std::printf("%-32s %14.1f %14.1f %+8.1f%% %9.0f%%  %s\n", name.c_str(), expected, actual,
+                change * 100, tolerance * 100, status);
+        }
+
+        if (failures != 0) {
+            std::printf("\n%d benchmark(s) regressed against %s\n", failures, baseline_path.c_str());
+            return 1;
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "rpfl_bench_compare: %s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,84 @@
+#include "archive_generator.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+// rpfl_generate: writes a deterministic synthetic archive
+//   --output PATH        file to write, "-" for standard output (required)
+//   --seed N             (default 1)
+//   --entries N          (default 10000)
+//   --median-size SIZE   median of the log-normal entry sizes (default 4K)
+//   --sigma X            log-normal sigma (default 1.5)
+//   --max-size SIZE      cap for regular entries (default 16M)
+//   --blobs N            number of big blobs (default 0)
+//   --blob-size SIZE     (default 256M)
+//   --min-depth N --max-depth N --fanout N   directory shape (1, 4, 16)
+//   --align MIX          alignment:weight list, e.g. 1:70,16:20,4096:10
+//   --endian big|little  (default big)
+//   --manifest none|sidecar|embedded
+//   --direct             write with OutputMode::Direct
+// SIZE accepts K, M and G suffixes.
+
+int main(int argc, char** argv) {
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+
+    GeneratorConfig config;
+    std::string output;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view flag = argv[i];
+            if (flag == "--direct") {
+                config.output_mode = OutputMode::Direct;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(std::string("missing value for ") + argv[i]);
+            }
+            std::string_view value = argv[++i];
+            if (flag == "--output") output = value;
+            else if (flag == "--seed") config.seed = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--entries") config.entries = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--median-size") config.median_size = parse_size(value);
+            else if (flag == "--sigma") config.size_sigma = std::strtod(value.data(), nullptr);
+            else if (flag == "--max-size") config.max_size = parse_size(value);
+            else if (flag == "--blobs") config.blob_count = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--blob-size") config.blob_size = parse_size(value);
+            else if (flag == "--min-depth") config.min_depth = static_cast<unsigned>(std::strtoul(value.data(), nullptr, 10));
+            else if (flag == "--max-depth") config.max_depth = static_cast<unsigned>(std::strtoul(value.data(), nullptr, 10));
+            else if (flag == "--fanout") config.fanout = static_cast<unsigned>(std::strtoul(value.data(), nullptr, 10));
+            else if (flag == "--align") config.alignments = parse_alignment_mix(value);
+            else if (flag == "--endian") {
+                if (value != "big" && value != "little") {
+                    throw std::invalid_argument("--endian takes big or little");
+                }
+                config.endianness = value == "big" ? Endianness::Big : Endianness::Little;
+            }
+            else if (flag == "--manifest") {
+                if (value != "none" && value != "sidecar" && value != "embedded") {
+                    throw std::invalid_argument("--manifest takes none, sidecar or embedded");
+                }
+                config.manifest_mode = value == "sidecar" ? ManifestMode::Sidecar
+                    : value == "embedded" ? ManifestMode::Embedded : ManifestMode::None;
+            }
+            else {
+                throw std::invalid_argument(std::string("unknown option ") + std::string(flag));
+            }
+        }
+        if (output.empty()) {
+            throw std::invalid_argument("--output is required");
+        }
+
+        GeneratorStats stats = generate_archive(config, output);
+        std::fprintf(stderr, "%llu entries, %llu data bytes, %llu archive bytes\n",
+            static_cast<unsigned long long>(stats.entries),
+            static_cast<unsigned long long>(stats.data_bytes),
+            static_cast<unsigned long long>(stats.archive_bytes));
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "rpfl_generate: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "RPFL.h"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+// rpfl_bench: ArchiveReader microbenchmarks over a synthetic archive, plus
+// packing a batch of small entries with ArchiveWriter
+//   --files N        entries in the generated archive (default 10000)
+//   --small-size N   bytes per small entry (default 1024)
+//   --large-size N   bytes per large entry (default 8 MiB, 4 of them)
+//   --min-time S     seconds per benchmark (default 0.2)
+//   --filter TEXT    only benchmarks whose name contains TEXT
+//   --repetitions N  measured batches per benchmark, the fastest counts (default 1)
+//   --json PATH      also write the results as JSON, for rpfl_bench_compare
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+
+    struct Options {
+        std::size_t files = 10000;
+        std::size_t small_size = 1024;
+        std::size_t large_size = 8 * 1024 * 1024;
+        std::size_t large_count = 4;
+        Settings settings;
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string_view flag = argv[i];
+            const char* value = argv[i + 1];
+            if (flag == "--files") options.files = std::strtoull(value, nullptr, 10);
+            else if (flag == "--small-size") options.small_size = std::strtoull(value, nullptr, 10);
+            else if (flag == "--large-size") options.large_size = std::strtoull(value, nullptr, 10);
+            else if (flag == "--min-time") options.settings.min_seconds = std::strtod(value, nullptr);
+            else if (flag == "--filter") options.settings.filter = value;
+            else if (flag == "--json") options.settings.json = value;
+            else if (flag == "--repetitions") options.settings.repetitions = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+            else {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                std::exit(2);
+            }
+        }
+        return options;
+    }
+
+    std::string small_path(std::size_t i) {
+        return "data/dir" + std::to_string(i % 64) + "/sub" + std::to_string(i % 7)
+            + "/file" + std::to_string(i) + ".bin";
+    }
+
+    std::string large_path(std::size_t i) {
+        return "blobs/large" + std::to_string(i) + ".bin";
+    }
+
+    void write_archive(const std::string& filepath, const Options& options) {
+        std::mt19937_64 random(42);
+        std::vector<std::byte> data(std::max(options.small_size, options.large_size));
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+
+        ArchiveWriter writer;
+        for (std::size_t i = 0; i < options.files; ++i) {
+            writer.add_file(small_path(i), std::span(data).first(options.small_size));
+        }
+        for (std::size_t i = 0; i < options.large_count; ++i) {
+            writer.add_file(large_path(i), std::span(data).first(options.large_size), 4096);
+        }
+        writer.write(filepath);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = parse_options(argc, argv);
+    auto filepath = (std::filesystem::temp_directory_path() / (unique_name("rpfl_bench") + ".gfs")).string();
+    write_archive(filepath, options);
+
+    std::vector<std::string> hits;
+    std::vector<std::string> misses;
+    for (std::size_t i = 0; i < options.files; ++i) {
+        hits.push_back(small_path(i));
+        misses.push_back(small_path(i) + ".missing");
+    }
+    // Visit entries out of order so lookups don't walk the table linearly
+    std::shuffle(hits.begin(), hits.end(), std::mt19937_64(7));
+    const std::size_t count = hits.size();
+    const Settings& settings = options.settings;
+
+    std::vector<Result> results;
+    auto run = [&](std::string name, std::uint64_t bytes_per_op, auto&& op) {
+        if (selected(name, settings)) {
+            results.push_back(measure(std::move(name), bytes_per_op, settings, op));
+            print(results.back());
+        }
+    };
+
+    print_header();
+
+    run("open", 0, [&](std::uint64_t) {
+        ArchiveReader reader(filepath);
+        keep(reader.file_count());
+    });
+
+    ArchiveReader reader(filepath, 1024 * 1024, true, true);
+
+    run("get_file/hit", 0, [&](std::uint64_t i) {
+        keep(reader.get_file(hits[i % count]).size());
+    });
+    run("contains/miss", 0, [&](std::uint64_t i) {
+        keep(reader.contains(misses[i % count]));
+    });
+    run("find/hit", 0, [&](std::uint64_t i) {
+        keep(reader.find(hits[i % count]));
+    });
+
+    run("data/cold", options.small_size, [&](std::uint64_t i) {
+        auto& file = reader.get_file(hits[i % count]);
+        file.release_cache();
+        keep(file.data().data());
+    });
+    for (const auto& path : hits) {
+        keep(reader.get_file(path).data().data());
+    }
+    run("data/cached", options.small_size, [&](std::uint64_t i) {
+        keep(reader.get_file(hits[i % count]).data().data());
+    });
+
+    run("read_raw", options.small_size, [&](std::uint64_t i) {
+        keep(reader.read_raw(hits[i % count]).data());
+    });
+
+    constexpr std::size_t kChunk = 64 * 1024;
+    auto& large = reader.get_file(large_path(0));
+    const std::size_t chunks = std::max<std::size_t>(1, options.large_size / kChunk);
+    run("read_chunk/64k", kChunk, [&](std::uint64_t i) {
+        keep(large.read_chunk((i % chunks) * kChunk, kChunk).data());
+    });
+
+    run("open_stream", 0, [&](std::uint64_t) {
+        keep(large.open_stream().get());
+    });
+    run("open_stream/read_4k", 4096, [&](std::uint64_t) {
+        char buffer[4096];
+        large.open_stream()->read(buffer, sizeof(buffer));
+        keep(buffer[0]);
+    });
+
+    run("files/iterate", 0, [&](std::uint64_t) {
+        std::uint64_t total = 0;
+        for (const auto& file : reader.files()) {
+            total += file->size();
+        }
+        keep(total);
+    });
+
+    constexpr std::size_t kPackEntries = 1000;
+    std::vector<std::byte> pack_data(options.small_size, std::byte{ 0x42 });
+    std::vector<std::string> pack_paths;
+    for (std::size_t i = 0; i < kPackEntries; ++i) {
+        pack_paths.push_back(small_path(i));
+    }
+    run("pack/1000_small", kPackEntries * options.small_size, [&](std::uint64_t) {
+        ArchiveWriter writer;
+        for (const auto& path : pack_paths) {
+            writer.add_file(path, pack_data);
+        }
+        keep(writer.write_to_memory().size());
+    });
+
+    std::filesystem::remove(filepath);
+    if (!settings.json.empty() && !write_json(results, settings.json)) {
+        std::fprintf(stderr, "could not write %s\n", settings.json.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include "RPFL.h"
+#include "archive_generator.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+// rpfl_bench_scaling: throughput and latency of a mixed read workload on
+// 1..N threads, against one shared ArchiveReader and against one reader
+// per thread
+//   --archive PATH     archive to read (default: generated, see --entries)
+//   --entries N        entries of the generated archive (default 100000)
+//   --threads LIST     thread counts, e.g. 1,2,4,8 (default powers of two
+//                      up to the hardware threads); 1 is always run, the
+//                      efficiency column is relative to it
+//   --seconds S        per run (default 1)
+//   --mix LIST         op:weight of lookup, cached, range, stream
+//                      (default lookup:40,cached:30,range:20,stream:10)
+//   --mode MODE        shared, per-thread or both (default both)
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+
+    enum Op { Lookup, Cached, Range, Stream, OpCount };
+    constexpr std::string_view kOpNames[OpCount] = { "lookup", "cached", "range", "stream" };
+    constexpr std::size_t kRangeSize = 4096;
+    constexpr std::size_t kStreamRead = 16 * 1024;
+
+    struct Options {
+        std::string archive;
+        std::uint64_t entries = 100000;
+        std::vector<unsigned> threads;
+        double seconds = 1.0;
+        unsigned weights[OpCount] = { 40, 30, 20, 10 };
+        bool shared = true;
+        bool per_thread = true;
+    };
+
+    std::vector<std::string_view> split(std::string_view text, char separator) {
+        std::vector<std::string_view> items;
+        while (!text.empty()) {
+            std::string_view item = text.substr(0, text.find(separator));
+            text.remove_prefix(std::min(text.size(), item.size() + 1));
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string_view flag = argv[i];
+            std::string_view value = argv[i + 1];
+            if (flag == "--archive") options.archive = value;
+            else if (flag == "--entries") options.entries = std::strtoull(value.data(), nullptr, 10);
+            else if (flag == "--seconds") options.seconds = std::strtod(value.data(), nullptr);
+            else if (flag == "--threads") {
+                for (auto item : split(value, ',')) {
+                    options.threads.push_back(static_cast<unsigned>(std::strtoul(std::string(item).c_str(), nullptr, 10)));
+                }
+            }
+            else if (flag == "--mode") {
+                options.shared = value != "per-thread";
+                options.per_thread = value != "shared";
+            }
+            else if (flag == "--mix") {
+                std::fill(std::begin(options.weights), std::end(options.weights), 0u);
+                for (auto item : split(value, ',')) {
+                    std::string_view name = item.substr(0, item.find(':'));
+                    auto op = std::find(std::begin(kOpNames), std::end(kOpNames), name) - std::begin(kOpNames);
+                    if (op == OpCount || name.size() == item.size()) {
+                        std::fprintf(stderr, "bad --mix item %.*s\n", static_cast<int>(item.size()), item.data());
+                        std::exit(2);
+                    }
+                    options.weights[op] = static_cast<unsigned>(
+                        std::strtoul(std::string(item.substr(name.size() + 1)).c_str(), nullptr, 10));
+                }
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                std::exit(2);
+            }
+        }
+        if (std::all_of(std::begin(options.weights), std::end(options.weights), [](unsigned w) { return w == 0; })) {
+            std::fprintf(stderr, "--mix needs at least one non-zero weight\n");
+            std::exit(2);
+        }
+        if (options.threads.empty()) {
+            unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned n = 1; n < hardware; n *= 2) {
+                options.threads.push_back(n);
+            }
+            options.threads.push_back(hardware);
+        }
+        for (unsigned& threads : options.threads) {
+            threads = std::max(threads, 1u);
+        }
+        if (std::ranges::find(options.threads, 1u) == options.threads.end()) {
+            options.threads.insert(options.threads.begin(), 1u);
+        }
+        return options;
+    }
+
+    struct ThreadResult {
+        std::uint64_t operations = 0;
+        std::uint64_t bytes = 0;
+        LatencyHistogram latencies; // ns, fixed size however long the run
+    };
+
+    struct RunResult {
+        unsigned threads = 0;
+        double ops_per_second = 0;
+        double bytes_per_second = 0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p99 = 0;
+        std::uint64_t p999 = 0;
+    };
+
+    void worker(ArchiveReader& reader, const Options& options, unsigned index,
+        const std::atomic<bool>& running, ThreadResult& result) {
+        const auto& files = reader.files();
+        std::vector<std::string_view> paths;
+        paths.reserve(files.size());
+        for (const auto& file : files) {
+            paths.push_back(file->path());
+        }
+
+        unsigned total_weight = 0;
+        for (unsigned weight : options.weights) {
+            total_weight += weight;
+        }
+
+        SplitMix64 random(0x5CA1AB1E + index);
+        char stream_buffer[kStreamRead];
+        while (running.load(std::memory_order_relaxed)) {
+            auto pick = static_cast<unsigned>(random.next() % total_weight);
+            int op = 0;
+            while (pick >= options.weights[op]) {
+                pick -= options.weights[op++];
+            }
+            std::size_t entry = static_cast<std::size_t>(random.next() % files.size());
+            ArchiveFile& file = *files[entry];
+
+            auto start = Clock::now();
+            switch (op) {
+            case Lookup:
+                keep(reader.find(paths[entry]));
+                break;
+            case Cached:
+                result.bytes += file.data().size();
+                keep(file.data().data());
+                break;
+            case Range: {
+                std::size_t offset = file.size() > kRangeSize
+                    ? static_cast<std::size_t>(random.next() % (file.size() - kRangeSize)) : 0;
+                auto chunk = file.read_chunk(offset, kRangeSize);
+                result.bytes += chunk.size();
+                keep(chunk.data());
+                break;
+            }
+            case Stream: {
+                auto stream = file.open_stream();
+                stream->read(stream_buffer, sizeof(stream_buffer));
+                result.bytes += static_cast<std::uint64_t>(stream->gcount());
+                keep(stream_buffer[0]);
+                break;
+            }
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+            result.latencies.record(static_cast<std::uint64_t>(elapsed.count()));
+            ++result.operations;
+        }
+    }
+
+    RunResult run(const std::string& archive, const Options& options, unsigned threads, bool shared) {
+        std::vector<std::unique_ptr<ArchiveReader>> readers;
+        for (unsigned i = 0; i < (shared ? 1 : threads); ++i) {
+            readers.push_back(std::make_unique<ArchiveReader>(archive));
+        }
+
+        std::atomic<bool> running{ true };
+        std::vector<ThreadResult> results(threads);
+        auto start = Clock::now();
+        {
+            std::vector<std::jthread> pool;
+            for (unsigned i = 0; i < threads; ++i) {
+                ArchiveReader& reader = *readers[shared ? 0 : i];
+                pool.emplace_back([&, i] { worker(reader, options, i, running, results[i]); });
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+            running = false;
+        }
+        double elapsed = seconds_since(start);
+
+        RunResult run;
+        run.threads = threads;
+        LatencyHistogram latencies;
+        std::uint64_t operations = 0;
+        std::uint64_t bytes = 0;
+        for (auto& result : results) {
+            operations += result.operations;
+            bytes += result.bytes;
+            latencies.merge(result.latencies);
+        }
+        run.ops_per_second = static_cast<double>(operations) / elapsed;
+        run.bytes_per_second = static_cast<double>(bytes) / elapsed;
+        run.p50 = latencies.percentile(50);
+        run.p99 = latencies.percentile(99);
+        run.p999 = latencies.percentile(99.9);
+        return run;
+    }
+
+    void report(std::string_view mode, const std::vector<RunResult>& runs) {
+        std::printf("\n%.*s reader\n", static_cast<int>(mode.size()), mode.data());
+        std::printf("%8s %14s %12s %10s %10s %10s %11s\n",
+            "threads", "ops/s", "MB/s", "p50 ns", "p99 ns", "p999 ns", "efficiency");
+        // parse_options() makes sure there is a single-thread run
+        double base_per_thread = std::ranges::find(runs, 1u, &RunResult::threads)->ops_per_second;
+        for (const auto& run : runs) {
+            std::printf("%8u %14.0f %12.1f %10llu %10llu %10llu %10.0f%%\n", run.threads,
+                run.ops_per_second, run.bytes_per_second / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(run.p50), static_cast<unsigned long long>(run.p99),
+                static_cast<unsigned long long>(run.p999),
+                100.0 * run.ops_per_second / (base_per_thread * run.threads));
+        }
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = parse_options(argc, argv);
+    bool generated = options.archive.empty();
+    if (generated) {
+        options.archive = (std::filesystem::temp_directory_path() / (unique_name("rpfl_bench_scaling") + ".gfs")).string();
+        GeneratorConfig config;
+        config.entries = options.entries;
+        config.max_size = 4 * 1024 * 1024;
+        config.blob_count = 4;
+        config.blob_size = 64 * 1024 * 1024;
+        generate_archive(config, options.archive);
+    }
+
+    // Workers pick entries at random, there has to be at least one
+    if (ArchiveReader(options.archive).file_count() == 0) {
+        std::fprintf(stderr, "%s has no entries to benchmark\n", options.archive.c_str());
+        if (generated) {
+            std::filesystem::remove(options.archive);
+        }
+        return 2;
+    }
+
+    for (bool shared : { true, false }) {
+        if (shared ? !options.shared : !options.per_thread) {
+            continue;
+        }
+        std::vector<RunResult> runs;
+        for (unsigned threads : options.threads) {
+            runs.push_back(run(options.archive, options, threads, shared));
+        }
+        report(shared ? "shared" : "per-thread", runs);
+    }
+
+    if (generated) {
+        std::filesystem::remove(options.archive);
+    }
+    return 0;
+}
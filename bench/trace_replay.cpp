@@ -0,0 +1,221 @@
+#include "RPFL.h"
+#include "archive_generator.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <exception>
+#include <thread>
+
+// rpfl_replay: re-executes an access trace recorded with
+// ArchiveReader::start_trace() against an archive and reports the latency
+// of every operation type
+//   --trace PATH           trace file (required)
+//   --archive PATH         archive to replay against (required)
+//   --speed original|max   keep the recorded timing or go flat out (default max)
+//   --cache-threshold SIZE entries up to SIZE are cached on data() (default 1M)
+//   --prefetch             MemoryMappedFile prefetch on
+//   --no-streaming         large entries are mapped views instead of streams
+//   --compact-paths        front-coded path index
+// Every traced thread gets its own replay thread. Paths the archive doesn't
+// have are counted as misses and skipped. A library built with
+// RPFL_ENABLE_LATENCY also prints its own histograms, which split data()
+// into first-touch and cached calls.
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+
+    constexpr std::size_t kPage = 4096;
+    constexpr std::size_t kOpCount = static_cast<std::size_t>(TraceOp::ReadRaw) + 1;
+    constexpr std::string_view kOpNames[kOpCount] = { "lookup", "data", "read_chunk", "open_stream", "read_raw" };
+
+    struct Options {
+        std::string trace;
+        std::string archive;
+        bool original_speed = false;
+        std::size_t cache_threshold = 1024 * 1024;
+        bool prefetch = false;
+        bool streaming = true;
+        bool compact_paths = false;
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string_view flag = argv[i];
+            if (flag == "--prefetch") options.prefetch = true;
+            else if (flag == "--no-streaming") options.streaming = false;
+            else if (flag == "--compact-paths") options.compact_paths = true;
+            else if (i + 1 < argc && flag == "--trace") options.trace = argv[++i];
+            else if (i + 1 < argc && flag == "--archive") options.archive = argv[++i];
+            else if (i + 1 < argc && flag == "--cache-threshold") options.cache_threshold = parse_size(argv[++i]);
+            else if (i + 1 < argc && flag == "--speed") {
+                std::string_view value = argv[++i];
+                if (value != "original" && value != "max") {
+                    throw std::invalid_argument("--speed takes original or max");
+                }
+                options.original_speed = value == "original";
+            }
+            else {
+                throw std::invalid_argument(std::string("unknown option ") + argv[i]);
+            }
+        }
+        if (options.trace.empty() || options.archive.empty()) {
+            throw std::invalid_argument("--trace and --archive are required");
+        }
+        return options;
+    }
+
+    struct ThreadResult {
+        std::vector<std::uint64_t> latencies[kOpCount]; // ns
+        std::uint64_t misses = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t max_lag_ns = 0; // behind the recorded schedule, original speed only
+    };
+
+    std::uint64_t touch(std::span<const std::byte> data) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < data.size(); i += kPage) {
+            sum += std::to_integer<std::uint8_t>(data[i]);
+        }
+        return sum;
+    }
+
+    void replay(ArchiveReader& reader, const AccessTrace& trace, const std::vector<ArchiveFile*>& resolved,
+        const std::vector<std::size_t>& records, bool original_speed, Clock::time_point start,
+        ThreadResult& result) {
+        for (std::size_t index : records) {
+            const TraceRecord& record = trace.records[index];
+            if (original_speed) {
+                auto due = start + std::chrono::nanoseconds(record.timestamp_ns);
+                std::this_thread::sleep_until(due);
+                auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count();
+                result.max_lag_ns = std::max(result.max_lag_ns, static_cast<std::uint64_t>(std::max<long long>(lag, 0)));
+            }
+
+            ArchiveFile* file = resolved[record.path];
+            if (!file) {
+                ++result.misses;
+                if (record.op != TraceOp::Lookup) {
+                    continue;
+                }
+            }
+
+            auto op_start = Clock::now();
+            switch (record.op) {
+            case TraceOp::Lookup:
+                keep(reader.find(trace.paths[record.path]));
+                break;
+            case TraceOp::Data: {
+                // A mapped view is only a span, fault its pages in like a caller would
+                auto data = file->data();
+                keep(touch(data));
+                result.bytes += data.size();
+                break;
+            }
+            case TraceOp::ReadChunk: {
+                auto chunk = file->read_chunk(static_cast<std::size_t>(record.offset),
+                    static_cast<std::size_t>(record.size));
+                result.bytes += chunk.size();
+                keep(chunk.data());
+                break;
+            }
+            case TraceOp::OpenStream:
+                keep(file->open_stream().get());
+                break;
+            case TraceOp::ReadRaw: {
+                auto raw = reader.read_raw(trace.paths[record.path]);
+                keep(touch(raw));
+                result.bytes += raw.size();
+                break;
+            }
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - op_start);
+            result.latencies[static_cast<std::size_t>(record.op)].push_back(static_cast<std::uint64_t>(elapsed.count()));
+        }
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parse_options(argc, argv);
+        AccessTrace trace = load_access_trace(options.trace);
+
+        MemoryMappedFile::Options mmap_options;
+        mmap_options.prefetch = options.prefetch;
+        ArchiveReader reader;
+        reader.set_compact_paths(options.compact_paths);
+        reader.open(options.archive, options.cache_threshold, true, options.streaming, mmap_options);
+
+        std::vector<ArchiveFile*> resolved;
+        resolved.reserve(trace.paths.size());
+        for (const auto& path : trace.paths) {
+            resolved.push_back(reader.find(path));
+        }
+        // One replay thread per recorded thread; the loader numbers them
+        // densely, so never more threads than records
+        std::size_t threads = std::min<std::size_t>(trace.thread_count, trace.records.size());
+        std::vector<std::vector<std::size_t>> per_thread(std::max<std::size_t>(threads, 1));
+        for (std::size_t i = 0; i < trace.records.size(); ++i) {
+            per_thread[trace.records[i].thread].push_back(i);
+        }
+
+        std::vector<ThreadResult> results(per_thread.size());
+        reset_latency();
+        auto start = Clock::now();
+        {
+            std::vector<std::jthread> pool;
+            for (std::size_t t = 0; t < per_thread.size(); ++t) {
+                pool.emplace_back([&, t] {
+                    replay(reader, trace, resolved, per_thread[t], options.original_speed, start, results[t]);
+                });
+            }
+        }
+        double elapsed = seconds_since(start);
+
+        double recorded = trace.records.empty() ? 0.0 : static_cast<double>(trace.records.back().timestamp_ns) * 1e-9;
+        std::uint64_t misses = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t max_lag = 0;
+        for (const auto& result : results) {
+            misses += result.misses;
+            bytes += result.bytes;
+            max_lag = std::max(max_lag, result.max_lag_ns);
+        }
+        std::printf("%zu records, %zu threads, %zu paths (%llu misses)\n", trace.records.size(),
+            per_thread.size(), trace.paths.size(), static_cast<unsigned long long>(misses));
+        std::printf("recorded %.3f s, replayed in %.3f s, %.1f MB/s", recorded, elapsed,
+            static_cast<double>(bytes) / (1024.0 * 1024.0) / std::max(elapsed, 1e-9));
+        if (options.original_speed) {
+            std::printf(", max lag %.3f ms", static_cast<double>(max_lag) * 1e-6);
+        }
+        std::printf("\n\n%-12s %10s %10s %10s %10s %10s %12s\n",
+            "op", "count", "p50 ns", "p90 ns", "p99 ns", "p999 ns", "max ns");
+        for (std::size_t op = 0; op < kOpCount; ++op) {
+            std::vector<std::uint64_t> latencies;
+            for (auto& result : results) {
+                latencies.insert(latencies.end(), result.latencies[op].begin(), result.latencies[op].end());
+            }
+            if (latencies.empty()) {
+                continue;
+            }
+            auto max = *std::max_element(latencies.begin(), latencies.end());
+            std::printf("%-12.*s %10zu %10llu %10llu %10llu %10llu %12llu\n",
+                static_cast<int>(kOpNames[op].size()), kOpNames[op].data(), latencies.size(),
+                static_cast<unsigned long long>(percentile(latencies, 0.50)),
+                static_cast<unsigned long long>(percentile(latencies, 0.90)),
+                static_cast<unsigned long long>(percentile(latencies, 0.99)),
+                static_cast<unsigned long long>(percentile(latencies, 0.999)),
+                static_cast<unsigned long long>(max));
+        }
+        if constexpr (latency_enabled()) {
+            std::printf("\nlibrary latency\n%s", latency().to_text().c_str());
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "rpfl_replay: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
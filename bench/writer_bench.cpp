@@ -0,0 +1,255 @@
+#include "RPFL.h"
+#include "archive_generator.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+// rpfl_bench_writer: ArchiveWriter throughput on generated trees of
+// different shapes, with the peak RSS and read/write syscalls of each step
+//   --shapes LIST      small, mixed, large (default all)
+//   --dir DIR          where trees and archives go (default temp dir)
+//   --repetitions N    runs per benchmark, the fastest counts (default 3)
+//   --json PATH        also write the results as JSON, for rpfl_bench_compare
+// Peak RSS and syscall counts come from /proc/self (VmHWM, reset through
+// clear_refs, and syscr/syscw in io); they read as 0 where that's missing.
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Bench;
+    namespace fs = std::filesystem;
+
+    struct Shape {
+        std::string_view name;
+        GeneratorConfig config;
+    };
+
+    std::vector<Shape> all_shapes() {
+        std::vector<Shape> shapes;
+
+        // Lots of tiny files in a deep tree, table and per-file costs dominate
+        GeneratorConfig small;
+        small.entries = 20000;
+        small.median_size = 1024;
+        small.size_sigma = 0.5;
+        small.max_size = 16 * 1024;
+        small.min_depth = 2;
+        small.max_depth = 6;
+        small.fanout = 8;
+        shapes.push_back({ "small", small });
+
+        // Log-normal sizes around 16 KiB with some page-aligned entries
+        GeneratorConfig mixed;
+        mixed.entries = 4000;
+        mixed.median_size = 16 * 1024;
+        mixed.max_size = 4 * 1024 * 1024;
+        mixed.alignments = { { 1, 80 }, { 4096, 20 } };
+        shapes.push_back({ "mixed", mixed });
+
+        // A few big blobs, copy bandwidth dominates
+        GeneratorConfig large;
+        large.entries = 32;
+        large.median_size = 8 * 1024 * 1024;
+        large.size_sigma = 0.2;
+        large.max_size = 16 * 1024 * 1024;
+        large.max_depth = 1;
+        shapes.push_back({ "large", large });
+        return shapes;
+    }
+
+    struct Options {
+        std::vector<std::string> shapes{ "small", "mixed", "large" };
+        std::string dir;
+        unsigned repetitions = 3;
+        std::string json;
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string_view flag = argv[i];
+            std::string_view value = argv[i + 1];
+            if (flag == "--dir") options.dir = value;
+            else if (flag == "--repetitions") options.repetitions = std::max(1u, static_cast<unsigned>(std::strtoul(value.data(), nullptr, 10)));
+            else if (flag == "--json") options.json = value;
+            else if (flag == "--shapes") {
+                options.shapes.clear();
+                while (!value.empty()) {
+                    std::string_view item = value.substr(0, value.find(','));
+                    value.remove_prefix(std::min(value.size(), item.size() + 1));
+                    options.shapes.emplace_back(item);
+                }
+            }
+            else {
+                std::fprintf(stderr, "unknown option %s\n", argv[i]);
+                std::exit(2);
+            }
+        }
+        return options;
+    }
+
+    // Resource use of one run, from /proc/self
+    struct Usage {
+        double seconds = 0;
+        std::uint64_t peak_rss = 0; // bytes
+        std::uint64_t rss_growth = 0; // peak over the RSS at the start
+        std::uint64_t read_calls = 0;
+        std::uint64_t write_calls = 0;
+    };
+
+    std::uint64_t proc_value(const char* file, std::string_view key) {
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.starts_with(key) && line.size() > key.size() && line[key.size()] == ':') {
+                return std::strtoull(line.c_str() + key.size() + 1, nullptr, 10);
+            }
+        }
+        return 0;
+    }
+
+    // Resets VmHWM to the current RSS (Linux 4.0+)
+    void reset_peak_rss() {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    template<typename Op>
+    Usage measure_usage(Op&& op) {
+        reset_peak_rss();
+        std::uint64_t start_rss = proc_value("/proc/self/status", "VmRSS") * 1024;
+        std::uint64_t reads = proc_value("/proc/self/io", "syscr");
+        std::uint64_t writes = proc_value("/proc/self/io", "syscw");
+        auto start = Clock::now();
+        op();
+        Usage usage;
+        usage.seconds = seconds_since(start);
+        usage.peak_rss = proc_value("/proc/self/status", "VmHWM") * 1024;
+        usage.rss_growth = usage.peak_rss > start_rss ? usage.peak_rss - start_rss : 0;
+        usage.read_calls = proc_value("/proc/self/io", "syscr") - reads;
+        usage.write_calls = proc_value("/proc/self/io", "syscw") - writes;
+        return usage;
+    }
+
+    // The generated archive unpacked into dir, so disk-based adds have a tree
+    void materialize(const std::string& archive, const fs::path& dir) {
+        ArchiveReader reader(archive);
+        for (const auto& file : reader.files()) {
+            fs::path target = dir / fs::path(std::string(file->path()));
+            fs::create_directories(target.parent_path());
+            std::ofstream out(target, std::ios::binary);
+            auto data = file->raw_data();
+            out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+    }
+
+    void print_usage_header() {
+        std::printf("%-8s %-26s %10s %10s %12s %10s %12s %12s\n",
+            "shape", "benchmark", "MB/s", "ms", "peak RSS MB", "growth MB", "read calls", "write calls");
+    }
+
+    void print_usage(std::string_view shape, std::string_view name, std::uint64_t bytes, const Usage& usage) {
+        std::printf("%-8.*s %-26.*s %10.1f %10.2f %12.1f %10.1f %12llu %12llu\n",
+            static_cast<int>(shape.size()), shape.data(), static_cast<int>(name.size()), name.data(),
+            bytes > 0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / std::max(usage.seconds, 1e-9) : 0.0,
+            usage.seconds * 1e3, static_cast<double>(usage.peak_rss) / (1024.0 * 1024.0),
+            static_cast<double>(usage.rss_growth) / (1024.0 * 1024.0),
+            static_cast<unsigned long long>(usage.read_calls), static_cast<unsigned long long>(usage.write_calls));
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options = parse_options(argc, argv);
+    fs::path root = (options.dir.empty() ? fs::temp_directory_path() : fs::path(options.dir)) / unique_name("rpfl_bench_writer");
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    // Reading /proc/self itself costs a few read calls, take them off
+    const Usage overhead = measure_usage([] {});
+
+    std::vector<Result> results;
+    print_usage_header();
+    for (const Shape& shape : all_shapes()) {
+        if (std::find(options.shapes.begin(), options.shapes.end(), shape.name) == options.shapes.end()) {
+            continue;
+        }
+        std::string source_archive = (root / (std::string(shape.name) + ".src.gfs")).string();
+        fs::path tree = root / std::string(shape.name);
+        GeneratorStats stats = generate_archive(shape.config, source_archive);
+        materialize(source_archive, tree);
+
+        ArchiveReader source(source_archive);
+        std::vector<std::pair<std::string, fs::path>> disk_files;
+        for (const auto& file : source.files()) {
+            std::string path(file->path());
+            disk_files.emplace_back(path, tree / fs::path(path));
+        }
+
+        // Runs op `repetitions` times and reports the fastest run; setup runs
+        // before every repetition, outside the measurement
+        auto run = [&](std::string name, std::uint64_t bytes, auto&& setup, auto&& op) {
+            Usage best;
+            for (unsigned i = 0; i < options.repetitions; ++i) {
+                setup();
+                Usage usage = measure_usage(op);
+                usage.read_calls -= std::min(usage.read_calls, overhead.read_calls);
+                usage.write_calls -= std::min(usage.write_calls, overhead.write_calls);
+                if (i == 0 || usage.seconds < best.seconds) {
+                    best = usage;
+                }
+            }
+            print_usage(shape.name, name, bytes, best);
+
+            Result result;
+            result.name = std::string(shape.name) + "/" + name;
+            result.iterations = options.repetitions;
+            result.ns_per_op = best.seconds * 1e9;
+            result.bytes_per_second = bytes > 0 ? static_cast<double>(bytes) / best.seconds : 0;
+            results.push_back(std::move(result));
+        };
+        auto no_setup = [] {};
+
+        std::unique_ptr<ArchiveWriter> writer;
+        auto fresh_writer = [&] { writer = std::make_unique<ArchiveWriter>(); };
+
+        run("add_file/span", stats.data_bytes, fresh_writer, [&] {
+            for (const auto& file : source.files()) {
+                writer->add_file(std::string(file->path()), file->raw_data(), file->align());
+            }
+        });
+        run("add_file_from_disk", stats.data_bytes, fresh_writer, [&] {
+            for (const auto& [path, file] : disk_files) {
+                writer->add_file_from_disk(file, path);
+            }
+        });
+        run("add_files_from_directory", stats.data_bytes, fresh_writer, [&] {
+            writer->add_files_from_directory(tree);
+        });
+
+        // A populated writer for the output benchmarks
+        ArchiveWriter populated;
+        for (const auto& file : source.files()) {
+            populated.add_file(std::string(file->path()), file->raw_data(), file->align());
+        }
+        std::uint64_t archive_bytes = populated.total_size();
+
+        run("total_size", 0, no_setup, [&] { keep(populated.total_size()); });
+        run("write_to_memory", archive_bytes, no_setup, [&] { keep(populated.write_to_memory().size()); });
+        std::string output = (root / (std::string(shape.name) + ".out.gfs")).string();
+        run("write(path)", archive_bytes, no_setup, [&] { populated.write(output); });
+        fs::remove(output);
+
+        writer.reset();
+        fs::remove_all(tree);
+        fs::remove(source_archive);
+    }
+
+    fs::remove_all(root);
+    if (!options.json.empty() && !write_json(results, options.json)) {
+        std::fprintf(stderr, "could not write %s\n", options.json.c_str());
+        return 1;
+    }
+    return 0;
+}
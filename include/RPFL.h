@@ -1,5 +1,18 @@
 #pragma once
 #include "archive_reader.hpp"
+#include "streaming_archive_reader.hpp"
+#include "access_trace.hpp"
+#include "archive_stats.hpp"
+#include "archive_latency.hpp"
 #include "archive_exception.hpp"
 #include "archive_common.hpp"
-#include "archive_writer.hpp"
\ No newline at end of file
+#include "archive_writer.hpp"
+#include "archive_overlay.hpp"
+#include "archive_search_path.hpp"
+#include "archive_hash.hpp"
+#include "archive_manifest.hpp"
+#include "archive_diff.hpp"
+#include "archive_patch.hpp"
+#include "pack_pipeline.hpp"
+#include "shared_snapshot.hpp"
+#include "path_utils.hpp"
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace RPFL {
+
+    enum class TraceOp : std::uint8_t {
+        Lookup,     // get_file / find / contains, hit or miss
+        Data,       // ArchiveFile::data() / as_string_view()
+        ReadChunk,  // ArchiveFile::read_chunk(offset, size)
+        OpenStream, // ArchiveFile::open_stream()
+        ReadRaw     // ArchiveReader::read_raw()
+    };
+
+    struct TraceRecord {
+        std::uint64_t timestamp_ns = 0; // since the trace started
+        std::uint32_t thread = 0;       // below AccessTrace::thread_count
+        std::uint32_t path = 0;         // index into AccessTrace::paths
+        TraceOp op = TraceOp::Lookup;
+        std::uint64_t offset = 0;       // byte range within the entry
+        std::uint64_t size = 0;
+    };
+
+    // A recorded trace, entries referenced by path so it replays against any
+    // archive that has them
+    struct AccessTrace {
+        std::vector<std::string> paths;
+        std::vector<TraceRecord> records;
+        // Loading renumbers threads 0..thread_count-1 in order of first
+        // appearance, so every thread has records
+        std::uint32_t thread_count = 0;
+    };
+
+    // Appends access records to a compact binary file, safe to call from
+    // any thread. Layout, integers are LEB128 varints:
+    //   "RPFLTRC1"
+    //   0x00 length bytes                                  new path, next id
+    //   0x01+op delta_ns thread path offset size           one access
+    // Records are buffered and hit the file in 64 KiB writes.
+    class AccessTraceRecorder {
+    public:
+        explicit AccessTraceRecorder(const std::string& filepath);
+        ~AccessTraceRecorder();
+
+        AccessTraceRecorder(const AccessTraceRecorder&) = delete;
+        AccessTraceRecorder& operator=(const AccessTraceRecorder&) = delete;
+
+        // Never throws: a failed write stops recording, see failed()
+        void record(TraceOp op, std::string_view path, std::uint64_t offset, std::uint64_t size) noexcept;
+
+        void flush();
+        bool failed() const noexcept;
+        std::uint64_t record_count() const noexcept;
+
+    private:
+        void put_varint(std::uint64_t value);
+        void flush_locked();
+
+        mutable std::mutex mutex_;
+        std::ofstream out_;
+        std::string buffer_;
+        std::chrono::steady_clock::time_point start_;
+        std::uint64_t last_ns_ = 0;
+        std::uint64_t records_ = 0;
+        // Transparent, so lookups by string_view don't build a string
+        struct PathHash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view path) const noexcept { return std::hash<std::string_view>{}(path); }
+        };
+        std::unordered_map<std::string, std::uint32_t, PathHash, std::equal_to<>> path_ids_;
+        std::unordered_map<std::thread::id, std::uint32_t> thread_ids_;
+        bool failed_ = false;
+    };
+
+    // Reads a whole trace written by AccessTraceRecorder
+    AccessTrace load_access_trace(const std::string& filepath);
+
+} // namespace RPFL
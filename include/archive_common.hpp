@@ -1,5 +1,7 @@
 #pragma once
 #include <bit>
+#include <cstdint>
+#include <cstring>
 #include <array>
 #include <ranges>
 #include <type_traits>
@@ -25,6 +27,16 @@ namespace RPFL {
     };
 
     //         
+    // Rounds offset up to a power-of-two alignment (0 and 1 mean none).
+    // The mask is widened first so offsets past 4 GB keep their high bits.
+    constexpr std::uint64_t align_up(std::uint64_t offset, std::uint32_t align) noexcept {
+        if (align <= 1) {
+            return offset;
+        }
+        std::uint64_t mask = static_cast<std::uint64_t>(align) - 1;
+        return (offset + mask) & ~mask;
+    }
+
     template<typename T>
         requires std::is_integral_v<T>
     void write_with_endianness(std::byte* dest, T value, Endianness endian) {
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "archive_reader.hpp"
+
+namespace RPFL {
+
+    struct DiffOptions {
+        unsigned threads = 0; // 0 = one per hardware thread
+        bool include_unchanged = false;
+    };
+
+    struct ArchiveDiff {
+        enum class Change {
+            Added,
+            Removed,
+            Moved, // same content under a new path
+            Changed,
+            Unchanged
+        };
+
+        struct Entry {
+            Change change;
+            const ArchiveFile* old_file; // nullptr for Added
+            const ArchiveFile* new_file; // nullptr for Removed
+        };
+
+        std::vector<Entry> entries; // ordered by path
+
+        std::size_t count(Change change) const noexcept;
+        // One line per entry: "A path", "D path", "M old -> new", "C path", "= path"
+        std::string to_string() const;
+    };
+
+    // Compares two archives straight from their mappings: entries are told
+    // apart by size first, only same-size candidates are compared byte for
+    // byte or, for move detection, hashed - all on a thread pool
+    ArchiveDiff diff(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        const DiffOptions& options = {});
+
+} // namespace RPFL
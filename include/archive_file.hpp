@@ -10,10 +10,14 @@
 #include <istream>
 #include <sstream>
 #include <functional>
+#include <atomic>
+
+#include "archive_latency.hpp"
 
 namespace RPFL {
 
     class ArchiveReader;
+    class AccessTraceRecorder;
 
     class ArchiveFile {
     public:
@@ -34,12 +38,16 @@ namespace RPFL {
 
         using DataHolder = std::variant<MappedView, CachedData, StreamData>;
 
-        ArchiveFile(std::string path,
+        // path must outlive the file, the reader passes a view into its mapping.
+        // data_owner, if set, keeps archive_data alive for open_stream() streams.
+        ArchiveFile(std::string_view path,
             std::uint64_t offset,
             std::uint64_t size,
             const std::byte* archive_data,
             std::size_t cache_threshold = 1024 * 1024,
-            bool allow_streaming = false);
+            bool allow_streaming = false,
+            std::uint32_t align = 1,
+            std::shared_ptr<const void> data_owner = nullptr);
 
         // Deny Copy
         ArchiveFile(const ArchiveFile&) = delete;
@@ -52,18 +60,29 @@ namespace RPFL {
         ~ArchiveFile();
 
         // Getters
-        const std::string& path() const noexcept { return path_; }
+        std::string_view path() const noexcept { return path_; }
         std::uint64_t size() const noexcept { return size_; }
         std::uint64_t offset() const noexcept { return offset_; }
+        std::uint32_t align() const noexcept { return align_; }
 
         // Recive data
         std::span<const std::byte> data();
         std::string_view as_string_view();
 
-        // stream reading
+        // View straight into the archive mapping, never touches the cache
+        std::span<const std::byte> raw_data() const noexcept {
+            return { archive_data_ + offset_, size_ };
+        }
+
+        // Stream over the archive data, co-owning it through data_owner: it
+        // stays valid after release_cache() and after the reader is closed
         std::shared_ptr<std::istream> open_stream();
         std::vector<std::byte> read_chunk(std::size_t offset, std::size_t size);
 
+        // Copies up to buffer.size() bytes from offset into buffer straight out
+        // of the archive mapping and returns the count. Never allocates.
+        std::size_t read(std::size_t offset, std::span<std::byte> buffer) const noexcept;
+
         // Checks, cached file or not
         bool is_cached() const noexcept;
 
@@ -78,17 +97,35 @@ namespace RPFL {
 
     private:
         void ensure_loaded();
+        void load_holder();
+        // data() and open_stream() without the trace record
+        std::span<const std::byte> load_data();
+        std::shared_ptr<std::istream> make_stream();
+        void copy_range(std::size_t offset, std::span<std::byte> out) const noexcept;
+        // FirstTouch until the entry is loaded, CachedData after
+        LatencyOp touch_op() const noexcept;
+        // Faults in a freshly loaded mapped view, see set_latency_touch_pages()
+        void touch_pages(LatencyOp op) const noexcept;
         std::vector<std::byte> read_from_stream(std::shared_ptr<std::istream> stream);
 
-        std::string path_;
+        std::string_view path_;
         std::uint64_t offset_;
         std::uint64_t size_;
+        std::uint32_t align_;
         const std::byte* archive_data_;
+        std::shared_ptr<const void> data_owner_;
         std::size_t cache_threshold_;
         DataHolder data_holder_;
-        bool is_loaded_ = false;
+        // First data() from several threads at once loads once, the others
+        // wait for it. release_cache() must not race with readers.
+        enum LoadState : std::uint8_t { Unloaded, Loading, Loaded };
+        std::atomic<std::uint8_t> load_state_{ Unloaded };
         bool supports_streaming_ = false;
         std::function<std::shared_ptr<std::istream>()> stream_factory_;
+        // Set by ArchiveReader::start_trace()
+        AccessTraceRecorder* trace_ = nullptr;
+
+        friend class ArchiveReader;
     };
 
 } // namespace RPFL
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace RPFL {
+
+    // CRC-32C (Castagnoli). Uses the SSE4.2 / ARMv8 crc32c instructions when
+    // the CPU has them, slicing-by-8 tables otherwise.
+    std::uint32_t crc32c(std::span<const std::byte> data, std::uint32_t crc = 0) noexcept;
+
+    // Incremental form for data that arrives in pieces
+    class Crc32c {
+    public:
+        void update(std::span<const std::byte> data) noexcept { crc_ = crc32c(data, crc_); }
+        std::uint32_t value() const noexcept { return crc_; }
+        void reset() noexcept { crc_ = 0; }
+
+    private:
+        std::uint32_t crc_ = 0;
+    };
+
+} // namespace RPFL
@@ -0,0 +1,193 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Per-operation latency histograms. Built in with the CMake option
+// RPFL_ENABLE_LATENCY; without it the timers compile to nothing and
+// latency() returns empty histograms.
+
+namespace RPFL {
+
+    enum class LatencyOp : std::size_t {
+        Open,       // ArchiveReader::open
+        Lookup,     // get_file / find / contains / read_raw
+        // data() / as_string_view() that loads the entry. For a mapped view
+        // loading only builds the span and its page faults hit the caller
+        // later, unless set_latency_touch_pages(true)
+        FirstTouch,
+        CachedData, // data() / as_string_view() on a loaded entry
+        RangeRead,  // read_chunk / read
+        StreamOpen, // open_stream
+        Count
+    };
+
+    constexpr std::size_t kLatencyOpCount = static_cast<std::size_t>(LatencyOp::Count);
+
+    const char* to_string(LatencyOp op) noexcept;
+
+    // Log-linear buckets over nanoseconds, like HdrHistogram: values below
+    // 2^kSubBucketBits get a bucket each, above that every power of two is
+    // split into 2^kSubBucketBits buckets, so a bucket is at most ~3% wide.
+    // Values past kMaxValue land in the last bucket.
+    class LatencyHistogram {
+    public:
+        static constexpr unsigned kSubBucketBits = 5;
+        static constexpr unsigned kMaxValueBits = 36; // ~68 s
+        static constexpr std::uint64_t kSubBuckets = std::uint64_t{ 1 } << kSubBucketBits;
+        static constexpr std::uint64_t kMaxValue = (std::uint64_t{ 1 } << kMaxValueBits) - 1;
+        static constexpr std::size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+        static constexpr std::size_t bucket_index(std::uint64_t ns) noexcept {
+            if (ns > kMaxValue) {
+                ns = kMaxValue;
+            }
+            if (ns < kSubBuckets) {
+                return static_cast<std::size_t>(ns);
+            }
+            unsigned msb = static_cast<unsigned>(std::bit_width(ns)) - 1;
+            unsigned shift = msb - kSubBucketBits;
+            return static_cast<std::size_t>((shift + 1) * kSubBuckets + ((ns >> shift) - kSubBuckets));
+        }
+
+        // Smallest and largest value that fall into a bucket
+        static constexpr std::uint64_t bucket_lower(std::size_t index) noexcept {
+            if (index < kSubBuckets) {
+                return index;
+            }
+            std::size_t shift = index / kSubBuckets - 1;
+            return (kSubBuckets + index % kSubBuckets) << shift;
+        }
+
+        static constexpr std::uint64_t bucket_upper(std::size_t index) noexcept {
+            std::size_t shift = index < kSubBuckets ? 0 : index / kSubBuckets - 1;
+            return bucket_lower(index) + (std::uint64_t{ 1 } << shift) - 1;
+        }
+
+        void record(std::uint64_t ns) noexcept;
+        // count values of bucket index adding up to total_ns, for rebuilding
+        // a histogram from its buckets
+        void add(std::size_t index, std::uint64_t count, std::uint64_t total_ns) noexcept;
+        void merge(const LatencyHistogram& other) noexcept;
+        // Takes out an earlier state of the same histogram, for intervals
+        void subtract(const LatencyHistogram& earlier) noexcept;
+        void clear() noexcept;
+
+        std::uint64_t count() const noexcept { return count_; }
+        std::uint64_t total_ns() const noexcept { return total_ns_; }
+        double mean() const noexcept;
+        // Bucket bounds, so within a bucket's width of the recorded values
+        std::uint64_t min() const noexcept;
+        std::uint64_t max() const noexcept;
+        // Highest value of the bucket holding the given percentile (0-100)
+        std::uint64_t percentile(double percent) const noexcept;
+
+        const std::array<std::uint64_t, kBucketCount>& buckets() const noexcept { return buckets_; }
+
+    private:
+        std::array<std::uint64_t, kBucketCount> buckets_{};
+        std::uint64_t count_ = 0;
+        std::uint64_t total_ns_ = 0;
+    };
+
+    struct LatencySnapshot {
+        std::array<LatencyHistogram, kLatencyOpCount> ops;
+
+        LatencyHistogram& operator[](LatencyOp op) noexcept { return ops[static_cast<std::size_t>(op)]; }
+        const LatencyHistogram& operator[](LatencyOp op) const noexcept { return ops[static_cast<std::size_t>(op)]; }
+
+        void merge(const LatencySnapshot& other) noexcept;
+        void subtract(const LatencySnapshot& earlier) noexcept;
+
+        // One line per operation: count, mean and the p50/p90/p99/p99.9/max tail
+        std::string to_text() const;
+        // Summary plus the non-empty buckets as [upper_ns, count] pairs
+        std::string to_json() const;
+    };
+
+    constexpr bool latency_enabled() noexcept {
+#ifdef RPFL_ENABLE_LATENCY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Merged over all threads since the last reset_latency()
+    LatencySnapshot latency();
+    void reset_latency();
+
+    // Makes a first-touch data() on a mapped-view entry read one byte per
+    // page inside the timed scope, so FirstTouch includes the page faults of
+    // cold entries. Off by default, it faults in whole entries the caller
+    // may only partly read. No effect without RPFL_ENABLE_LATENCY.
+    void set_latency_touch_pages(bool touch_pages) noexcept;
+    bool latency_touch_pages() noexcept;
+
+    namespace detail {
+
+#ifdef RPFL_ENABLE_LATENCY
+        // One per thread, only its thread writes, read by latency(); same
+        // scheme as CounterBlock in archive_stats.hpp. Created on the first
+        // timed call, which may be noexcept: if registering it runs out of
+        // memory the thread's timings are dropped instead of terminating.
+        struct LatencyBlock {
+            std::atomic<std::uint64_t> buckets[kLatencyOpCount][LatencyHistogram::kBucketCount]{};
+            std::atomic<std::uint64_t> total_ns[kLatencyOpCount]{};
+            bool registered = false;
+
+            LatencyBlock() noexcept;
+            ~LatencyBlock();
+            LatencyBlock(const LatencyBlock&) = delete;
+            LatencyBlock& operator=(const LatencyBlock&) = delete;
+        };
+
+        inline LatencyBlock& local_latency() {
+            thread_local LatencyBlock block;
+            return block;
+        }
+
+        inline void record_latency(LatencyOp op, std::uint64_t ns) noexcept {
+            auto& block = local_latency();
+            std::size_t index = static_cast<std::size_t>(op);
+            auto& bucket = block.buckets[index][LatencyHistogram::bucket_index(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            auto& total = block.total_ns[index];
+            total.store(total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        }
+
+        // Times its own lifetime into op's histogram
+        class LatencyScope {
+        public:
+            explicit LatencyScope(LatencyOp op) noexcept
+                : op_(op), start_(std::chrono::steady_clock::now()) {}
+
+            ~LatencyScope() {
+                auto elapsed = std::chrono::steady_clock::now() - start_;
+                record_latency(op_, static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+
+            LatencyScope(const LatencyScope&) = delete;
+            LatencyScope& operator=(const LatencyScope&) = delete;
+
+        private:
+            LatencyOp op_;
+            std::chrono::steady_clock::time_point start_;
+        };
+#else
+        class LatencyScope {
+        public:
+            explicit LatencyScope(LatencyOp) noexcept {}
+            LatencyScope(const LatencyScope&) = delete;
+            LatencyScope& operator=(const LatencyScope&) = delete;
+        };
+#endif
+
+    } // namespace detail
+
+} // namespace RPFL
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "archive_exception.hpp"
+
+namespace RPFL {
+
+    // Per-entry layout and CRC-32C of an archive. Stored as text, one entry
+    // per line after the header line:
+    //   <crc32c, 8 hex digits> <offset> <size> <align> <path>
+    class ArchiveManifest {
+    public:
+        struct Entry {
+            std::string path;
+            std::uint64_t offset = 0;
+            std::uint64_t size = 0;
+            std::uint32_t align = 1;
+            std::uint32_t crc32c = 0;
+        };
+
+        static constexpr std::string_view kHeader = "RPFL-MANIFEST 1 crc32c";
+        // Entry name of a manifest stored inside its archive (always the last entry)
+        static constexpr std::string_view kEmbeddedPath = ".rpfl/manifest";
+
+        // Length of one text line, known before the CRC is
+        static std::uint64_t line_size(std::size_t path_size, std::uint64_t offset,
+            std::uint64_t size, std::uint32_t align) noexcept;
+
+        void add(Entry entry);
+        void clear() noexcept;
+
+        const std::vector<Entry>& entries() const noexcept { return entries_; }
+        const Entry* find(std::string_view path) const noexcept;
+        std::size_t size() const noexcept { return entries_.size(); }
+
+        // Text form
+        std::string to_string() const;
+        static ArchiveManifest parse(std::string_view text);
+
+        void save(const std::string& filepath) const;
+        static ArchiveManifest load(const std::string& filepath);
+
+    private:
+        struct PathHash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view path) const noexcept {
+                return std::hash<std::string_view>{}(path);
+            }
+        };
+
+        std::vector<Entry> entries_;
+        std::unordered_map<std::string, std::size_t, PathHash, std::equal_to<>> index_;
+    };
+
+} // namespace RPFL
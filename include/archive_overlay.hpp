@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "archive_reader.hpp"
+#include "archive_exception.hpp"
+
+namespace RPFL {
+
+    // Mounts several archives on top of each other (base game + mods).
+    // Higher priority wins; on equal priority the archive mounted last wins.
+    // The merged index is updated incrementally on mount/unmount, so a lookup
+    // is one hash probe no matter how many archives are mounted.
+    class ArchiveOverlay {
+    public:
+        using MountId = std::uint32_t;
+
+        struct Entry {
+            ArchiveFile* file;
+            ArchiveReader* reader;
+            MountId mount;
+            int priority;
+        };
+
+        ArchiveOverlay() = default;
+
+        // Mounted readers must stay open while they are mounted
+        MountId mount(std::shared_ptr<ArchiveReader> reader, int priority = 0);
+        bool unmount(MountId id);
+        void clear() noexcept;
+
+        // Lookup
+        const Entry* find(std::string_view path) const noexcept;
+        bool contains(std::string_view path) const noexcept;
+        ArchiveFile& get_file(std::string_view path) const;
+        std::span<const std::byte> read_raw(std::string_view path) const;
+
+        // Info
+        std::size_t file_count() const noexcept { return index_.size(); }
+        std::size_t mount_count() const noexcept { return mounts_.size(); }
+        std::shared_ptr<ArchiveReader> reader(MountId id) const noexcept;
+
+    private:
+        struct Mount {
+            MountId id;
+            int priority;
+            std::shared_ptr<ArchiveReader> reader;
+        };
+
+        std::vector<Mount>::const_iterator find_mount(MountId id) const noexcept;
+        static bool outranks(const Entry& a, const Entry& b) noexcept;
+        void set_winner(std::unordered_map<std::string_view, Entry>::iterator it,
+            const Entry& entry);
+
+        // Ordered from the highest rank to the lowest
+        std::vector<Mount> mounts_;
+        std::unordered_map<std::string_view, Entry> index_;
+        MountId next_id_ = 0;
+    };
+
+} // namespace RPFL
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "archive_reader.hpp"
+
+namespace RPFL {
+
+    struct PatchOptions {
+        unsigned threads = 0; // 0 = one per hardware thread
+        // Granularity of the rolling-hash match; raised for very large
+        // entries so the block index stays around a million blocks
+        std::size_t block_size = 64;
+    };
+
+    struct PatchStats {
+        std::size_t copied = 0;  // taken unchanged from the old archive
+        std::size_t delta = 0;   // rebuilt from old data plus a binary delta
+        std::size_t literal = 0; // shipped whole
+        std::uint64_t patch_size = 0;
+        std::uint64_t new_archive_size = 0;
+    };
+
+    // Writes a patch turning old_archive into new_archive. Entries with the
+    // same content anywhere in the old archive (matched by size and CRC-32C,
+    // then compared) become copy instructions, changed entries a rolling-hash
+    // delta against their old version when that is smaller than the data
+    // itself; hashes and deltas are computed in parallel.
+    PatchStats create_patch(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        std::ostream& patch, const PatchOptions& options = {});
+    PatchStats create_patch(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        const std::string& patch_path, const PatchOptions& options = {});
+
+    // Streams the new archive from the old one and the patch in one pass over
+    // each: old data is copied straight out of the mapping and the patch is
+    // read in small chunks, so memory use does not depend on archive size.
+    // Every rebuilt entry is checked against the CRC-32C recorded in the patch.
+    void apply_patch(const ArchiveReader& old_archive, std::istream& patch, std::ostream& out);
+    void apply_patch(const ArchiveReader& old_archive, const std::string& patch_path,
+        const std::string& out_path);
+
+} // namespace RPFL
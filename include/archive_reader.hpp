@@ -6,11 +6,19 @@
 #include <unordered_map>
 #include <string_view>
 #include <span>
+#include <optional>
 
 #include "memory_mapped_file.hpp"
 #include "archive_file.hpp"
+#include "compact_path_table.hpp"
+#include "path_utils.hpp"
+#include "path_filter.hpp"
 #include "archive_exception.hpp"
 #include "archive_common.hpp"
+#include "archive_verify.hpp"
+#include "access_trace.hpp"
+#include "archive_stats.hpp"
+#include "archive_latency.hpp"
 
 namespace RPFL {
 
@@ -46,10 +54,21 @@ namespace RPFL {
         Endianness endianness() const noexcept { return file_endianness_; }
 
         //   
-        ArchiveFile& get_file(const std::string& path);
-        const ArchiveFile& get_file(const std::string& path) const;
+        ArchiveFile& get_file(std::string_view path);
+        const ArchiveFile& get_file(std::string_view path) const;
 
-        bool contains(const std::string& path) const noexcept;
+        bool contains(std::string_view path) const noexcept;
+
+        // Lookup without throwing, nullptr if the file is not in the archive
+        ArchiveFile* find(std::string_view path) const noexcept;
+
+        // Queries over the path-sorted index built at open time, O(log n + k).
+        // With a normalized index the order and the matching fold paths too.
+        std::span<ArchiveFile* const> sorted_files() const noexcept { return sorted_files_; }
+        std::span<ArchiveFile* const> list_dir(std::string_view dir) const noexcept;
+        std::span<ArchiveFile* const> list_range(std::string_view first,
+            std::string_view last) const noexcept;
+        std::vector<ArchiveFile*> glob(std::string_view pattern) const;
 
         //   
         const std::vector<std::unique_ptr<ArchiveFile>>& files() const noexcept;
@@ -59,7 +78,14 @@ namespace RPFL {
         std::size_t cache_size() const noexcept; //    
 
         //    
-        std::span<const std::byte> read_raw(const std::string& path) const;
+        std::span<const std::byte> read_raw(std::string_view path) const;
+
+        // CRC-32C of every entry on a thread pool, walking the archive in
+        // offset order; optionally checked against a manifest
+        VerifyReport verify(const VerifyOptions& options = {}) const;
+
+        // Manifest written by ArchiveWriter in ManifestMode::Embedded, if any
+        std::optional<ArchiveManifest> embedded_manifest() const;
 
         //  
         void set_cache_threshold(std::size_t threshold) { cache_threshold_ = threshold; }
@@ -68,6 +94,35 @@ namespace RPFL {
         void set_mmap_options(const MemoryMappedFile::Options& options) { mmap_options_ = options; }
         void set_file_endianness(Endianness endianness) { file_endianness_ = endianness; }
 
+        // Front-coded path index instead of the hash map, for big archives kept
+        // open in numbers: much less memory for an O(log n) lookup. Entry paths
+        // then view the mapped file table directly. Applies on the next open(),
+        // an open reader keeps the index it was opened with.
+        void set_compact_paths(bool compact_paths) { compact_paths_ = compact_paths; }
+        bool compact_paths() const noexcept { return compact_paths_; }
+        std::size_t index_memory_usage() const noexcept;
+
+        // Case-insensitive lookups that treat '\\' as '/': "Data\\Foo.DDS" finds
+        // "data/foo.dds". Keys are normalized once on open(), queries are folded
+        // while hashing without allocating. Takes precedence over compact paths.
+        // Like set_compact_paths(), applies on the next open().
+        void set_normalized_lookup(bool normalized_lookup) { normalized_lookup_ = normalized_lookup; }
+        bool normalized_lookup() const noexcept { return normalized_lookup_; }
+        // Whether the index and path_filter() of the open archive fold paths
+        bool normalized_index() const noexcept { return normalized_index_; }
+
+        // Bloom filter over the paths built on open(), lets ArchiveSearchPath
+        // skip this archive on most misses. Empty unless enabled.
+        void set_path_filter(bool path_filter) { build_path_filter_ = path_filter; }
+        const PathFilter& path_filter() const noexcept { return path_filter_; }
+
+        // Records lookups and entry reads (see access_trace.hpp) to filepath
+        // until stop_trace(), across reopens. raw_data() views are not seen.
+        // Start and stop while no other thread uses the reader.
+        void start_trace(const std::string& filepath);
+        void stop_trace();
+        bool is_tracing() const noexcept { return trace_ != nullptr; }
+
     private:
         struct Header {
             std::uint32_t data_offset;
@@ -78,11 +133,35 @@ namespace RPFL {
         void parse_header(std::span<const std::byte> data);
         void parse_file_table(std::span<const std::byte> data,
             std::uint32_t data_offset);
-
-        MemoryMappedFile mmap_file_;
+        void build_sorted_index();
+        void build_normalized_index();
+        void build_filter();
+        void attach_trace() noexcept;
+        // lookup() counts hits and misses, lookup_index() only searches
+        ArchiveFile* lookup(std::string_view path) const noexcept;
+        ArchiveFile* lookup_index(std::string_view path) const noexcept;
+        // What sorted_files_ is ordered by
+        std::string_view sorted_key(std::size_t index) const noexcept {
+            return normalized_index_ ? sorted_keys_[index] : sorted_files_[index]->path();
+        }
+
+        // Shared with the streams open_stream() hands out, which outlive close()
+        std::shared_ptr<MemoryMappedFile> mmap_file_;
         Header header_;
         std::vector<std::unique_ptr<ArchiveFile>> files_;
+        // All paths back to back, the entries view into it (unless compact_paths_)
+        std::vector<char> path_storage_;
         std::unordered_map<std::string_view, ArchiveFile*> file_map_;
+        std::vector<ArchiveFile*> sorted_files_;
+        // Normalized path of each sorted_files_ entry, empty unless normalized_index_
+        std::vector<std::string_view> sorted_keys_;
+        CompactPathTable compact_table_;
+        // Normalized copies of every path, keys of normalized_map_
+        std::vector<char> normalized_storage_;
+        std::unordered_map<std::string_view, ArchiveFile*,
+            NormalizedPathHash, NormalizedPathEqual> normalized_map_;
+        PathFilter path_filter_;
+        std::unique_ptr<AccessTraceRecorder> trace_;
         bool is_open_ = false;
 
         //  
@@ -91,6 +170,12 @@ namespace RPFL {
         bool allow_streaming_ = true;
         MemoryMappedFile::Options mmap_options_;
         Endianness file_endianness_ = Endianness::Big;
+        bool compact_paths_ = false;
+        // The modes as of open(), what the index and path views were built for
+        bool compact_index_ = false;
+        bool normalized_index_ = false;
+        bool normalized_lookup_ = false;
+        bool build_path_filter_ = false;
 
         friend class ArchiveWriter;
     };
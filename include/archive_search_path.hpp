@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "archive_reader.hpp"
+#include "archive_exception.hpp"
+
+namespace RPFL {
+
+    // Ordered list of archives probed one after another, first match wins.
+    // The path is hashed once and checked against each reader's PathFilter
+    // (see ArchiveReader::set_path_filter), so archives that can't hold it
+    // are skipped with a bit test instead of a hash map probe.
+    class ArchiveSearchPath {
+    public:
+        struct Result {
+            ArchiveFile* file = nullptr;
+            ArchiveReader* reader = nullptr;
+
+            explicit operator bool() const noexcept { return file != nullptr; }
+        };
+
+        ArchiveSearchPath() = default;
+
+        // Searched after every archive added before it
+        void add(std::shared_ptr<ArchiveReader> reader);
+        void clear() noexcept { readers_.clear(); }
+
+        Result find(std::string_view path) const noexcept;
+        bool contains(std::string_view path) const noexcept { return static_cast<bool>(find(path)); }
+        ArchiveFile& get_file(std::string_view path) const;
+        std::span<const std::byte> read_raw(std::string_view path) const;
+
+        std::size_t size() const noexcept { return readers_.size(); }
+
+    private:
+        std::vector<std::shared_ptr<ArchiveReader>> readers_;
+    };
+
+} // namespace RPFL
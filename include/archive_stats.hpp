@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide counters of what the library does. Built in with the CMake
+// option RPFL_ENABLE_STATS; without it every counter call compiles to
+// nothing and stats() reads all zeros.
+
+namespace RPFL {
+
+    struct ArchiveStats {
+        std::uint64_t lookups = 0;         // get_file / find / contains / read_raw
+        std::uint64_t lookup_hits = 0;
+        std::uint64_t lookup_misses = 0;
+        std::uint64_t loads = 0;           // first data() of an entry
+        std::uint64_t cache_fills = 0;     // loads that copied the entry into a cache
+        std::uint64_t bytes_copied = 0;    // out of the mapping: cache fills, read_chunk, read
+        std::uint64_t bytes_cached = 0;    // held in entry caches right now, unaffected by reset
+        std::uint64_t cache_evictions = 0; // release_cache(), including on close
+        std::uint64_t maps = 0;            // MemoryMappedFile::open
+        std::uint64_t bytes_mapped = 0;
+        std::uint64_t stream_opens = 0;
+    };
+
+    constexpr bool stats_enabled() noexcept {
+#ifdef RPFL_ENABLE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Sum over all threads since the last reset_stats()
+    ArchiveStats stats();
+    void reset_stats();
+
+    namespace detail {
+
+        enum Counter : std::size_t {
+            LookupHits,
+            LookupMisses,
+            Loads,
+            CacheFills,
+            BytesCopied,
+            BytesCacheFilled,
+            BytesEvicted,
+            CacheEvictions,
+            Maps,
+            BytesMapped,
+            StreamOpens,
+            CounterCount
+        };
+
+#ifdef RPFL_ENABLE_STATS
+        // One per thread, only its thread writes, so an increment is a plain
+        // load and store without a locked instruction; stats() reads them all.
+        // count() is noexcept, so a block that can't be registered for lack
+        // of memory just goes uncounted.
+        struct CounterBlock {
+            std::atomic<std::uint64_t> values[CounterCount]{};
+            bool registered = false;
+
+            CounterBlock() noexcept;
+            ~CounterBlock();
+            CounterBlock(const CounterBlock&) = delete;
+            CounterBlock& operator=(const CounterBlock&) = delete;
+        };
+
+        inline CounterBlock& local_counters() {
+            thread_local CounterBlock block;
+            return block;
+        }
+
+        inline void count(Counter counter, std::uint64_t amount = 1) noexcept {
+            auto& value = local_counters().values[counter];
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+#else
+        inline void count(Counter, std::uint64_t = 1) noexcept {}
+#endif
+
+    } // namespace detail
+
+} // namespace RPFL
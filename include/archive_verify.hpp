@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "archive_file.hpp"
+#include "archive_manifest.hpp"
+
+namespace RPFL {
+
+    struct VerifyOptions {
+        unsigned threads = 0; // 0 = one per hardware thread
+        const ArchiveManifest* manifest = nullptr; // optional, compared by size and CRC
+    };
+
+    struct VerifyReport {
+        struct Entry {
+            const ArchiveFile* file;
+            std::uint32_t crc32c;
+        };
+
+        std::vector<Entry> entries; // offset order
+        std::vector<std::string> mismatched; // size or CRC differs from the manifest
+        std::vector<std::string> missing; // in the manifest, not in the archive
+        std::vector<std::string> unexpected; // in the archive, not in the manifest
+
+        bool ok() const noexcept {
+            return mismatched.empty() && missing.empty() && unexpected.empty();
+        }
+
+        ArchiveManifest to_manifest() const;
+    };
+
+} // namespace RPFL
@@ -1,6 +1,8 @@
 #pragma once
 #include "archive_common.hpp"
 #include "archive_exception.hpp"
+#include "archive_manifest.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -14,11 +16,60 @@
 
 namespace RPFL {
 
+    // CRC manifest produced while writing: none, next to the archive
+    // ("<file>.manifest", write(filepath) only) or inside it as the last entry
+    // named ArchiveManifest::kEmbeddedPath, which old readers see as a plain file
+    enum class ManifestMode {
+        None,
+        Sidecar,
+        Embedded
+    };
+
+    // How write(filepath) gets the archive to disk. Big archives written
+    // through the page cache evict whatever else the machine is serving.
+    enum class OutputMode {
+        Buffered,  // std::ofstream
+        DropCache, // buffered, written back and dropped from the cache in windows
+        Direct     // O_DIRECT with aligned double buffering, DropCache where refused
+    };
+
+    struct IngestOptions {
+        unsigned threads = 0; // 0 = one per hardware thread
+        // Cap on data read from disk but not yet handed to the writer;
+        // a single bigger file is still read, alone
+        std::uint64_t max_in_flight_bytes = 256ull * 1024 * 1024;
+        // Files at least this big are added with add_file_streamed() instead
+        // of being read now, 0 = read everything
+        std::uint64_t stream_threshold = 0;
+        std::uint32_t alignment = 0;
+        std::function<bool(const std::filesystem::path&)> filter;
+    };
+
+    struct IngestReport {
+        struct Error {
+            std::filesystem::path file;
+            std::string message;
+        };
+
+        std::size_t added = 0;
+        std::uint64_t bytes = 0;
+        std::vector<Error> errors; // in archive path order
+
+        bool ok() const noexcept { return errors.empty(); }
+    };
+
     class ArchiveWriter {
     public:
+        // Receives the archive bytes in order, chunk by chunk
+        using ChunkSink = std::function<void(std::span<const std::byte>)>;
+        // Produces an entry's bytes when it is written, exactly the declared size
+        using EntrySource = std::function<void(const ChunkSink&)>;
+
         struct FileEntry {
             std::string path;
             std::vector<std::byte> data;
+            std::uint64_t size = 0; // data.size(), or what source will produce
+            EntrySource source; // set instead of data for streamed entries
             std::uint32_t align = 1; //   (1 =  )
             std::uint64_t offset = 0; //    (  )
         };
@@ -58,11 +109,23 @@ namespace RPFL {
             add_file(path, std::span<const std::byte>(data, size), alignment);
         }
 
+        // Entry whose data is streamed from source at write time, nothing is
+        // copied into the writer. Sources run in the order files were added.
+        void add_file_source(const std::string& path, std::uint64_t size,
+            EntrySource source, std::uint32_t alignment = 0);
+
         //    
         bool add_file_from_disk(const std::filesystem::path& filepath,
             const std::string& archive_path = "",
             std::uint32_t alignment = 0);
 
+        // Disk entry sized by stat now and read in stream_chunk_size() pieces
+        // at write time, so the archive never holds its data. The file must
+        // keep its size until then. Returns false if it can't be stat'ed.
+        bool add_file_streamed(const std::filesystem::path& filepath,
+            const std::string& archive_path = "",
+            std::uint32_t alignment = 0);
+
         //  
         bool remove_file(const std::string& path);
         void clear();
@@ -75,12 +138,22 @@ namespace RPFL {
         //  
         void write(const std::string& filepath);
         void write(std::ostream& stream);
+        // Single forward pass: header and table, then every entry with its padding
+        void write(const ChunkSink& sink);
+        // Pipe, socket or file descriptor, which stays owned by the caller;
+        // small pieces are gathered into one stream_chunk_size() buffer
+        void write(int fd);
         std::vector<std::byte> write_to_memory();
 
         //  
-        void add_files_from_directory(const std::filesystem::path& dir,
+        IngestReport add_files_from_directory(const std::filesystem::path& dir,
             const std::string& prefix = "",
             std::function<bool(const std::filesystem::path&)> filter = nullptr);
+        // Walks the tree first, then reads files on a thread pool. Entries are
+        // added sorted by archive path whatever the read order, and files that
+        // fail are reported instead of skipped silently.
+        IngestReport add_files_from_directory(const std::filesystem::path& dir,
+            const std::string& prefix, const IngestOptions& options);
 
         //  
         bool update_file(const std::string& path, std::span<const std::byte> new_data);
@@ -90,18 +163,39 @@ namespace RPFL {
         void set_version(const std::string& version) { version_ = version; }
         void set_endianness(Endianness endianness) { endianness_ = endianness; }
         void set_default_alignment(std::uint32_t alignment) { default_alignment_ = alignment; }
+        void set_manifest_mode(ManifestMode mode) { manifest_mode_ = mode; }
+        void set_output_mode(OutputMode mode) { output_mode_ = mode; }
+        OutputMode output_mode() const noexcept { return output_mode_; }
+        void set_stream_chunk_size(std::size_t size) { stream_chunk_size_ = std::max<std::size_t>(size, 1); }
+        std::size_t stream_chunk_size() const noexcept { return stream_chunk_size_; }
+
+        // Manifest of the last write, hashed as the data was copied
+        const ArchiveManifest& manifest() const noexcept { return manifest_; }
 
     private:
         std::string identifier_ = "Reverge Package File";
         std::string version_ = "1.1";
         Endianness endianness_ = Endianness::Big;
         std::uint32_t default_alignment_ = 1;
-        std::unordered_map<std::string, FileEntry> files_;
+        // Insertion order is archive order
+        std::vector<FileEntry> files_;
+        std::unordered_map<std::string, std::size_t> file_index_;
+        ManifestMode manifest_mode_ = ManifestMode::None;
+        ArchiveManifest manifest_;
+        std::size_t stream_chunk_size_ = 64 * 1024;
+        OutputMode output_mode_ = OutputMode::Buffered;
+
+        bool embeds_manifest() const noexcept { return manifest_mode_ == ManifestMode::Embedded; }
+        std::uint64_t manifest_size() const;
 
         std::uint64_t calculate_header_size() const;
         void write_header(std::byte* buffer, std::uint64_t& offset) const;
         void write_file_table(std::byte* buffer, std::uint64_t& offset) const;
-        void write_file_data(std::byte* buffer, std::uint64_t& offset) const;
+        void add_entry(FileEntry entry, std::uint32_t alignment);
+        // Padding up to the entry's alignment, then its data; advances offset
+        void write_entry(FileEntry& entry, std::uint64_t& offset, const ChunkSink& sink);
+
+        friend class PackPipeline;
     };
 
 } // namespace RPFL
\ No newline at end of file
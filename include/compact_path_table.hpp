@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace RPFL {
+
+    // Sorted paths stored front-coded: every block of kBlockSize paths keeps
+    // its first path whole, the rest as (shared prefix length, suffix). A small
+    // restart index of block offsets allows a binary search over blocks, so a
+    // lookup decodes at most one block and never allocates.
+    class CompactPathTable {
+    public:
+        static constexpr std::size_t kBlockSize = 16;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        CompactPathTable() = default;
+
+        // paths must be sorted
+        void build(std::span<const std::string_view> sorted_paths);
+        void clear() noexcept;
+
+        // Position of path in the sorted order, npos if missing
+        std::size_t find(std::string_view path) const noexcept;
+
+        // Decodes a single path (one block at most)
+        void path_at(std::size_t index, std::string& out) const;
+
+        // Visits every path in order, decoding block by block
+        template<typename F>
+        void for_each(F&& visit) const {
+            std::string path;
+            std::size_t pos = 0;
+            for (std::size_t index = 0; index < count_; ++index) {
+                pos = decode_entry(pos, index % kBlockSize == 0, path);
+                visit(index, std::string_view(path));
+            }
+        }
+
+        std::size_t size() const noexcept { return count_; }
+        bool empty() const noexcept { return count_ == 0; }
+        std::size_t memory_usage() const noexcept {
+            return bytes_.capacity() + restarts_.capacity() * sizeof(std::size_t);
+        }
+
+    private:
+        std::string_view block_head(std::size_t block) const noexcept;
+        // Applies the entry at pos to path (the previous path), returns the next pos
+        std::size_t decode_entry(std::size_t pos, bool head, std::string& path) const;
+
+        std::vector<char> bytes_;
+        std::vector<std::size_t> restarts_;
+        std::size_t count_ = 0;
+    };
+
+} // namespace RPFL
@@ -7,12 +7,16 @@
 
 namespace RPFL {
 
+    // Declared outside MemoryMappedFile so its default member initializers
+    // are usable in the default arguments below (GCC rejects the nested form)
+    struct MemoryMappedFileOptions {
+        bool read_only = true;
+        bool prefetch = false;
+    };
+
     class MemoryMappedFile {
     public:
-        struct Options {
-            bool read_only = true;
-            bool prefetch = false;
-        };
+        using Options = MemoryMappedFileOptions;
 
         MemoryMappedFile() = default;
         explicit MemoryMappedFile(const std::string& filepath,
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "archive_writer.hpp"
+
+namespace RPFL {
+
+    struct PackOptions {
+        unsigned threads = 0; // transform threads, 0 = one per hardware thread
+        // Files between the reader and the writer at any time, each holding
+        // its input and its output; 0 = twice the transform threads
+        std::size_t queue_depth = 0;
+    };
+
+    struct PackItem {
+        std::filesystem::path source;
+        std::string path; // inside the archive
+        std::uint32_t alignment = 0;
+    };
+
+    struct PackStats {
+        std::size_t files = 0;
+        std::uint64_t input_bytes = 0;
+        std::uint64_t output_bytes = 0;
+    };
+
+    // Read -> transform -> write over bounded queues: one thread reads the
+    // sources in order, the transform runs on a pool, and the calling thread
+    // writes results in table order as soon as the next one is ready. Memory
+    // stays at queue_depth files whatever the archive size. Output sizes are
+    // only known after the transform, so the header and table are reserved
+    // up front and filled in at the end: the output has to be seekable.
+    class PackPipeline {
+    public:
+        // Bytes of the source file in, bytes to store out
+        using Transform = std::function<std::vector<std::byte>(const PackItem& item,
+            std::vector<std::byte> data)>;
+
+        // Entries already in the writer are written first, unchanged; settings
+        // (identifier, endianness, alignment, manifest mode) come from it too
+        explicit PackPipeline(ArchiveWriter& writer, PackOptions options = {});
+
+        void add(std::filesystem::path source, std::string path, std::uint32_t alignment = 0);
+        void set_transform(Transform transform) { transform_ = std::move(transform); }
+        std::size_t item_count() const noexcept { return items_.size(); }
+
+        PackStats run(const std::string& filepath);
+        PackStats run(std::ostream& stream);
+
+    private:
+        ArchiveWriter& writer_;
+        PackOptions options_;
+        Transform transform_;
+        std::vector<PackItem> items_;
+    };
+
+} // namespace RPFL
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace RPFL {
+
+    // Blocked Bloom filter over archive paths. All bits of one path live in a
+    // single 64-byte block, so a negative answer costs one cache line. False
+    // positives are possible (~1% at the default 10 bits per path), false
+    // negatives are not.
+    class PathFilter {
+    public:
+        static constexpr std::size_t kDefaultBitsPerPath = 10;
+
+        PathFilter() = default;
+
+        void build(std::span<const std::uint64_t> hashes,
+            std::size_t bits_per_path = kDefaultBitsPerPath);
+        void clear() noexcept { blocks_.clear(); }
+
+        bool might_contain(std::uint64_t hash) const noexcept;
+        bool empty() const noexcept { return blocks_.empty(); }
+        std::size_t memory_usage() const noexcept { return blocks_.capacity() * sizeof(Block); }
+
+        // Path hashes the filters use, the normalized flavour folds case and slashes
+        static std::uint64_t hash(std::string_view path) noexcept;
+        static std::uint64_t normalized_hash(std::string_view path) noexcept;
+
+    private:
+        struct alignas(64) Block {
+            std::uint64_t words[8];
+        };
+        static constexpr int kBitsPerBlockPath = 6;
+
+        std::size_t block_index(std::uint64_t hash) const noexcept;
+        static std::uint64_t probe_bits(std::uint64_t hash) noexcept;
+
+        std::vector<Block> blocks_;
+    };
+
+} // namespace RPFL
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace RPFL {
+
+    // Glob over archive paths: '*' and '?' stop at '/', '**' crosses
+    // directories and "**/" matches zero or more of them
+    bool glob_match(std::string_view pattern, std::string_view path) noexcept;
+
+    // Part of a glob pattern before its first wildcard
+    std::string_view glob_literal_prefix(std::string_view pattern) noexcept;
+
+    // True for "dir/..." entries; "dir" and "dir/" name the same directory
+    bool is_under_directory(std::string_view path, std::string_view dir) noexcept;
+
+    // Path normalization for case-insensitive lookup: ASCII letters are
+    // lower-cased and '\\' becomes '/'. Length never changes.
+    constexpr char fold_path_char(char c) noexcept {
+        if (c >= 'A' && c <= 'Z') {
+            return static_cast<char>(c | 0x20);
+        }
+        return c == '\\' ? '/' : c;
+    }
+
+    // Vectorized (SSE2/NEON) normalization of size bytes from src to dst
+    void normalize_path(const char* src, char* dst, std::size_t size) noexcept;
+
+    // A raw query matched against already normalized keys, folded on the fly
+    struct UnnormalizedPath {
+        std::string_view path;
+    };
+
+    struct NormalizedPathHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view normalized) const noexcept {
+            return hash(normalized, [](char c) { return c; });
+        }
+        std::size_t operator()(UnnormalizedPath query) const noexcept {
+            return hash(query.path, fold_path_char);
+        }
+
+    private:
+        // FNV-1a, cheap enough to fold each byte as it goes
+        template<typename Fold>
+        static std::size_t hash(std::string_view path, Fold fold) noexcept {
+            std::uint64_t h = 14695981039346656037ull;
+            for (char c : path) {
+                h ^= static_cast<unsigned char>(fold(c));
+                h *= 1099511628211ull;
+            }
+            return static_cast<std::size_t>(h);
+        }
+    };
+
+    struct NormalizedPathEqual {
+        using is_transparent = void;
+
+        bool operator()(std::string_view a, std::string_view b) const noexcept {
+            return a == b;
+        }
+        bool operator()(UnnormalizedPath query, std::string_view normalized) const noexcept {
+            if (query.path.size() != normalized.size()) {
+                return false;
+            }
+            for (std::size_t i = 0; i < normalized.size(); ++i) {
+                if (fold_path_char(query.path[i]) != normalized[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        bool operator()(std::string_view normalized, UnnormalizedPath query) const noexcept {
+            return (*this)(query, normalized);
+        }
+    };
+
+} // namespace RPFL
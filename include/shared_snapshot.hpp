@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "archive_reader.hpp"
+#include "archive_overlay.hpp"
+
+namespace RPFL {
+
+    // Holds the current version of an archive (or overlay) for many threads.
+    // A new version is published atomically: lookups after publish() see it
+    // right away, while handles taken earlier keep the old one - and with it
+    // the old mapping and every span read from it - alive until they drop.
+    // Readers never take a lock; publish() and update() are serialized.
+    // Entries can be read from any thread, a first data() racing with another
+    // loads once. Only release_cache()/release_all_caches() must not overlap
+    // with readers of the same version.
+    template<typename T>
+    class SharedSnapshot {
+    public:
+        using Handle = std::shared_ptr<T>;
+
+        SharedSnapshot() = default;
+        explicit SharedSnapshot(Handle value) : current_(std::move(value)) {}
+
+        // Deny Copy
+        SharedSnapshot(const SharedSnapshot&) = delete;
+        SharedSnapshot& operator=(const SharedSnapshot&) = delete;
+
+        // Current version, keep the handle for as long as its data is used
+        Handle acquire() const noexcept {
+#ifdef __cpp_lib_atomic_shared_ptr
+            return current_.load(std::memory_order_acquire);
+#else
+            return std::atomic_load_explicit(&current_, std::memory_order_acquire);
+#endif
+        }
+
+        // Swaps in a new version, returns the previous one. Waits for an
+        // update() in progress, which would otherwise overwrite it.
+        Handle publish(Handle value) {
+            std::lock_guard lock(update_mutex_);
+            return exchange(std::move(value));
+        }
+
+        // Copy-on-write change: edits a copy of the current version and
+        // publishes it. Only for copyable values such as ArchiveOverlay.
+        template<typename F>
+        Handle update(F&& edit) {
+            std::lock_guard lock(update_mutex_);
+            Handle current = acquire();
+            auto next = current ? std::make_shared<T>(*current) : std::make_shared<T>();
+            std::forward<F>(edit)(*next);
+            exchange(next);
+            return next;
+        }
+
+    private:
+        Handle exchange(Handle value) noexcept {
+#ifdef __cpp_lib_atomic_shared_ptr
+            return current_.exchange(std::move(value), std::memory_order_acq_rel);
+#else
+            return std::atomic_exchange_explicit(&current_, std::move(value),
+                std::memory_order_acq_rel);
+#endif
+        }
+
+#ifdef __cpp_lib_atomic_shared_ptr
+        std::atomic<Handle> current_;
+#else
+        Handle current_;
+#endif
+        std::mutex update_mutex_;
+    };
+
+    using SharedArchive = SharedSnapshot<ArchiveReader>;
+    using SharedOverlay = SharedSnapshot<ArchiveOverlay>;
+
+} // namespace RPFL
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive_common.hpp"
+#include "archive_exception.hpp"
+
+namespace RPFL {
+
+    // Single forward pass over an archive arriving through a pipe or socket:
+    // header and table are parsed up front, then entries are handed out in
+    // offset order and their data read in bounded chunks. Never seeks, so
+    // skipped data and alignment padding are read and dropped.
+    class StreamingArchiveReader {
+    public:
+        struct Entry {
+            std::string_view path;
+            std::uint64_t offset;
+            std::uint64_t size;
+            std::uint32_t align;
+        };
+
+        // Fills the buffer with up to its size, 0 at end of input
+        using ReadFunction = std::function<std::size_t(std::span<std::byte>)>;
+
+        static constexpr std::size_t kDefaultChunkSize = 64 * 1024;
+
+        explicit StreamingArchiveReader(std::istream& stream,
+            Endianness file_endianness = Endianness::Big,
+            std::size_t chunk_size = kDefaultChunkSize);
+        // Reads a file descriptor (pipe, socket, regular file), which stays owned by the caller
+        explicit StreamingArchiveReader(int fd,
+            Endianness file_endianness = Endianness::Big,
+            std::size_t chunk_size = kDefaultChunkSize);
+        explicit StreamingArchiveReader(ReadFunction read,
+            Endianness file_endianness = Endianness::Big,
+            std::size_t chunk_size = kDefaultChunkSize);
+
+        StreamingArchiveReader(const StreamingArchiveReader&) = delete;
+        StreamingArchiveReader& operator=(const StreamingArchiveReader&) = delete;
+
+        std::string_view identifier() const noexcept { return identifier_; }
+        std::string_view version() const noexcept { return version_; }
+        std::size_t file_count() const noexcept { return entries_.size(); }
+        Endianness endianness() const noexcept { return file_endianness_; }
+
+        // The whole table, in offset order
+        std::span<const Entry> entries() const noexcept { return entries_; }
+
+        // Moves to the next entry, dropping what is left of the current one.
+        // nullptr once every entry has been passed.
+        const Entry* next();
+        const Entry* current() const noexcept;
+        std::uint64_t remaining() const noexcept { return remaining_; }
+
+        // Up to chunk_size bytes of the current entry, valid until the next
+        // call; empty once the entry is exhausted
+        std::span<const std::byte> read_chunk();
+        // Up to buffer.size() bytes of the current entry into the caller's buffer
+        std::size_t read(std::span<std::byte> buffer);
+        // Rest of the current entry in one allocation
+        std::vector<std::byte> read_all();
+
+        // Bytes consumed from the input so far
+        std::uint64_t position() const noexcept { return position_; }
+
+    private:
+        void parse_table();
+        void read_exact(std::byte* data, std::size_t size);
+        void discard(std::uint64_t size);
+
+        ReadFunction read_;
+        Endianness file_endianness_;
+        std::vector<std::byte> buffer_;
+        std::string identifier_;
+        std::string version_;
+        std::vector<char> path_storage_;
+        std::vector<Entry> entries_;
+        static constexpr std::size_t kNoEntry = static_cast<std::size_t>(-1);
+        std::size_t current_; // kNoEntry before the first next(), file_count() after the last
+        std::uint64_t remaining_ = 0;
+        std::uint64_t position_ = 0;
+    };
+
+} // namespace RPFL
@@ -0,0 +1,203 @@
+#include "access_trace.hpp"
+#include "archive_exception.hpp"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <unordered_map>
+
+namespace RPFL {
+
+    namespace {
+
+        constexpr std::array<char, 8> kTraceMagic{ 'R', 'P', 'F', 'L', 'T', 'R', 'C', '1' };
+        constexpr std::uint8_t kPathTag = 0x00;
+        constexpr std::uint8_t kRecordTag = 0x01;
+        constexpr std::size_t kFlushSize = 64 * 1024;
+        constexpr std::size_t kMaxPath = 64 * 1024;
+
+        class TraceInput {
+        public:
+            TraceInput(std::vector<char> data, std::size_t position)
+                : data_(std::move(data)), position_(position) {}
+
+            bool at_end() const noexcept { return position_ == data_.size(); }
+
+            std::uint8_t byte() {
+                if (position_ == data_.size()) {
+                    throw ArchiveFormatException("Trace is truncated");
+                }
+                return static_cast<std::uint8_t>(data_[position_++]);
+            }
+
+            std::uint64_t varint() {
+                std::uint64_t value = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7) {
+                    std::uint8_t b = byte();
+                    value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                    if ((b & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw ArchiveFormatException("Malformed varint in trace");
+            }
+
+            std::string string() {
+                std::uint64_t size = varint();
+                if (size > kMaxPath || size > data_.size() - position_) {
+                    throw ArchiveFormatException("Trace is truncated");
+                }
+                std::string text(data_.data() + position_, static_cast<std::size_t>(size));
+                position_ += static_cast<std::size_t>(size);
+                return text;
+            }
+
+        private:
+            std::vector<char> data_;
+            std::size_t position_;
+        };
+
+    } // namespace
+
+    AccessTraceRecorder::AccessTraceRecorder(const std::string& filepath)
+        : out_(filepath, std::ios::binary | std::ios::trunc)
+        , start_(std::chrono::steady_clock::now()) {
+        if (!out_) {
+            throw IOError("Failed to create trace file: " + filepath);
+        }
+        buffer_.reserve(kFlushSize + 256);
+        buffer_.append(kTraceMagic.data(), kTraceMagic.size());
+    }
+
+    AccessTraceRecorder::~AccessTraceRecorder() {
+        std::lock_guard lock(mutex_);
+        try {
+            flush_locked();
+        }
+        catch (...) {
+            // Nothing to report to from a destructor
+        }
+    }
+
+    void AccessTraceRecorder::record(TraceOp op, std::string_view path,
+        std::uint64_t offset, std::uint64_t size) noexcept {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard lock(mutex_);
+        if (failed_) {
+            return;
+        }
+        try {
+            // Timestamps are taken before the lock, keep them monotonic in file order
+            auto ns = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count());
+            ns = std::max(ns, last_ns_);
+
+            auto path_it = path_ids_.find(path);
+            if (path_it == path_ids_.end()) {
+                path_it = path_ids_.emplace(std::string(path), static_cast<std::uint32_t>(path_ids_.size())).first;
+                buffer_.push_back(static_cast<char>(kPathTag));
+                put_varint(path.size());
+                buffer_.append(path);
+            }
+            auto thread_it = thread_ids_.try_emplace(std::this_thread::get_id(),
+                static_cast<std::uint32_t>(thread_ids_.size())).first;
+
+            buffer_.push_back(static_cast<char>(kRecordTag + static_cast<std::uint8_t>(op)));
+            put_varint(ns - last_ns_);
+            put_varint(thread_it->second);
+            put_varint(path_it->second);
+            put_varint(offset);
+            put_varint(size);
+            last_ns_ = ns;
+            ++records_;
+
+            if (buffer_.size() >= kFlushSize) {
+                flush_locked();
+            }
+        }
+        catch (...) {
+            failed_ = true;
+        }
+    }
+
+    void AccessTraceRecorder::flush() {
+        std::lock_guard lock(mutex_);
+        flush_locked();
+    }
+
+    bool AccessTraceRecorder::failed() const noexcept {
+        std::lock_guard lock(mutex_);
+        return failed_;
+    }
+
+    std::uint64_t AccessTraceRecorder::record_count() const noexcept {
+        std::lock_guard lock(mutex_);
+        return records_;
+    }
+
+    void AccessTraceRecorder::put_varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+    void AccessTraceRecorder::flush_locked() {
+        if (buffer_.empty() || failed_) {
+            return;
+        }
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        out_.flush();
+        buffer_.clear();
+        if (!out_) {
+            failed_ = true;
+            throw IOError("Failed to write trace file");
+        }
+    }
+
+    AccessTrace load_access_trace(const std::string& filepath) {
+        std::ifstream in(filepath, std::ios::binary);
+        if (!in) {
+            throw IOError("Failed to open trace file: " + filepath);
+        }
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (data.size() < kTraceMagic.size() || !std::equal(kTraceMagic.begin(), kTraceMagic.end(), data.begin())) {
+            throw ArchiveFormatException("Not an access trace: " + filepath);
+        }
+
+        TraceInput input(std::move(data), kTraceMagic.size());
+        AccessTrace trace;
+        std::uint64_t timestamp = 0;
+        // Recorded thread number -> dense index; a damaged or hand-made trace
+        // can hold any 64-bit value there
+        std::unordered_map<std::uint64_t, std::uint32_t> threads;
+        while (!input.at_end()) {
+            std::uint8_t tag = input.byte();
+            if (tag == kPathTag) {
+                trace.paths.push_back(input.string());
+                continue;
+            }
+            if (tag > kRecordTag + static_cast<std::uint8_t>(TraceOp::ReadRaw)) {
+                throw ArchiveFormatException("Unknown record in trace");
+            }
+
+            TraceRecord record;
+            timestamp += input.varint();
+            record.timestamp_ns = timestamp;
+            record.op = static_cast<TraceOp>(tag - kRecordTag);
+            std::uint64_t thread = input.varint();
+            std::uint64_t path = input.varint();
+            record.offset = input.varint();
+            record.size = input.varint();
+            if (path >= trace.paths.size()) {
+                throw ArchiveFormatException("Trace references an undefined path");
+            }
+            record.path = static_cast<std::uint32_t>(path);
+            record.thread = threads.try_emplace(thread, static_cast<std::uint32_t>(threads.size())).first->second;
+            trace.records.push_back(record);
+        }
+        trace.thread_count = static_cast<std::uint32_t>(threads.size());
+        return trace;
+    }
+
+} // namespace RPFL
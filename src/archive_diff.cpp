@@ -0,0 +1,170 @@
+#include "archive_diff.hpp"
+#include "archive_hash.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace RPFL {
+
+    namespace {
+
+        bool same_content(const ArchiveFile& a, const ArchiveFile& b) noexcept {
+            auto x = a.raw_data();
+            auto y = b.raw_data();
+            return x.size() == y.size() && (x.empty() || std::memcmp(x.data(), y.data(), x.size()) == 0);
+        }
+
+        std::string_view sort_path(const ArchiveDiff::Entry& entry) noexcept {
+            return entry.new_file ? entry.new_file->path() : entry.old_file->path();
+        }
+
+    } // namespace
+
+    std::size_t ArchiveDiff::count(Change change) const noexcept {
+        return static_cast<std::size_t>(std::ranges::count(entries, change, &Entry::change));
+    }
+
+    std::string ArchiveDiff::to_string() const {
+        std::string text;
+        for (const auto& entry : entries) {
+            switch (entry.change) {
+            case Change::Added: text += "A "; break;
+            case Change::Removed: text += "D "; break;
+            case Change::Moved: text += "M "; break;
+            case Change::Changed: text += "C "; break;
+            case Change::Unchanged: text += "= "; break;
+            }
+            if (entry.change == Change::Moved) {
+                text += entry.old_file->path();
+                text += " -> ";
+            }
+            text += sort_path(entry);
+            text += '\n';
+        }
+        return text;
+    }
+
+    ArchiveDiff diff(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        const DiffOptions& options) {
+        using Change = ArchiveDiff::Change;
+
+        std::vector<ArchiveDiff::Entry> same_size;
+        std::vector<const ArchiveFile*> added;
+        std::vector<const ArchiveFile*> removed;
+        ArchiveDiff result;
+
+        for (const auto& file : new_archive.files()) {
+            const ArchiveFile* old_file = old_archive.find(file->path());
+            if (!old_file) {
+                added.push_back(file.get());
+            }
+            else if (old_file->size() != file->size()) {
+                result.entries.push_back({ Change::Changed, old_file, file.get() });
+            }
+            else {
+                same_size.push_back({ Change::Unchanged, old_file, file.get() });
+            }
+        }
+        for (const auto& file : old_archive.files()) {
+            if (!new_archive.find(file->path())) {
+                removed.push_back(file.get());
+            }
+        }
+
+        // Same path, same size: only the bytes can tell
+        parallel_for(same_size.size(), options.threads, [&same_size](std::size_t i) {
+            auto& entry = same_size[i];
+            if (!same_content(*entry.old_file, *entry.new_file)) {
+                entry.change = Change::Changed;
+            }
+        });
+        for (const auto& entry : same_size) {
+            if (entry.change == Change::Changed || options.include_unchanged) {
+                result.entries.push_back(entry);
+            }
+        }
+
+        // Moves: hash only removed/added entries whose size exists on both sides
+        std::unordered_set<std::uint64_t> removed_sizes;
+        for (const ArchiveFile* file : removed) {
+            removed_sizes.insert(file->size());
+        }
+        std::vector<const ArchiveFile*> to_hash;
+        std::vector<bool> is_candidate(added.size(), false);
+        for (std::size_t i = 0; i < added.size(); ++i) {
+            if (removed_sizes.contains(added[i]->size())) {
+                is_candidate[i] = true;
+                to_hash.push_back(added[i]);
+            }
+        }
+        if (!to_hash.empty()) {
+            std::unordered_set<std::uint64_t> added_sizes;
+            for (const ArchiveFile* file : to_hash) {
+                added_sizes.insert(file->size());
+            }
+            for (const ArchiveFile* file : removed) {
+                if (added_sizes.contains(file->size())) {
+                    to_hash.push_back(file);
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> hashes(to_hash.size());
+        parallel_for(to_hash.size(), options.threads, [&](std::size_t i) {
+            hashes[i] = crc32c(to_hash[i]->raw_data());
+        });
+        std::unordered_map<const ArchiveFile*, std::uint32_t> hash_of;
+        for (std::size_t i = 0; i < to_hash.size(); ++i) {
+            hash_of.emplace(to_hash[i], hashes[i]);
+        }
+
+        // (size, crc) -> removed entries still available as a move source
+        std::unordered_multimap<std::uint64_t, const ArchiveFile*> sources;
+        for (const ArchiveFile* file : removed) {
+            auto it = hash_of.find(file);
+            if (it != hash_of.end()) {
+                sources.emplace(file->size() * 0x9e3779b97f4a7c15ull ^ it->second, file);
+            }
+        }
+
+        std::vector<bool> moved_away(removed.size(), false);
+        std::unordered_map<const ArchiveFile*, std::size_t> removed_index;
+        for (std::size_t i = 0; i < removed.size(); ++i) {
+            removed_index.emplace(removed[i], i);
+        }
+
+        for (std::size_t i = 0; i < added.size(); ++i) {
+            const ArchiveFile* source = nullptr;
+            if (is_candidate[i]) {
+                auto key = added[i]->size() * 0x9e3779b97f4a7c15ull ^ hash_of.at(added[i]);
+                auto [first, last] = sources.equal_range(key);
+                for (auto it = first; it != last; ++it) {
+                    // The hash only nominates, the bytes decide
+                    if (same_content(*it->second, *added[i])) {
+                        source = it->second;
+                        sources.erase(it);
+                        break;
+                    }
+                }
+            }
+            if (source) {
+                moved_away[removed_index.at(source)] = true;
+                result.entries.push_back({ Change::Moved, source, added[i] });
+            }
+            else {
+                result.entries.push_back({ Change::Added, nullptr, added[i] });
+            }
+        }
+        for (std::size_t i = 0; i < removed.size(); ++i) {
+            if (!moved_away[i]) {
+                result.entries.push_back({ Change::Removed, removed[i], nullptr });
+            }
+        }
+
+        std::ranges::sort(result.entries, {}, sort_path);
+        return result;
+    }
+
+} // namespace RPFL
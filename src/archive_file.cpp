@@ -1,4 +1,7 @@
 #include "archive_file.hpp"
+#include "access_trace.hpp"
+#include "archive_stats.hpp"
+#include "archive_latency.hpp"
 #include <cstring>
 #include <algorithm>
 #include <sstream>
@@ -7,28 +10,76 @@
 
 namespace RPFL {
 
-    ArchiveFile::ArchiveFile(std::string path,
+    namespace {
+
+        // Read-only istream over a span, seekable, what open_stream() hands out
+        class SpanStreamBuf : public std::streambuf {
+        public:
+            explicit SpanStreamBuf(std::span<const std::byte> data) {
+                // The get area is never written through
+                char* begin = const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+                setg(begin, begin, begin + data.size());
+            }
+
+        protected:
+            pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                std::ios_base::openmode which) override {
+                if (!(which & std::ios_base::in)) {
+                    return pos_type(off_type(-1));
+                }
+                off_type base = dir == std::ios_base::beg ? 0
+                    : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+                off_type target = base + offset;
+                if (target < 0 || target > egptr() - eback()) {
+                    return pos_type(off_type(-1));
+                }
+                setg(eback(), eback() + target, egptr());
+                return pos_type(target);
+            }
+
+            pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+                return seekoff(off_type(position), std::ios_base::beg, which);
+            }
+        };
+
+        // Holds owner, whatever keeps data alive, for as long as it is read
+        class SpanStream : public std::istream {
+        public:
+            SpanStream(std::span<const std::byte> data, std::shared_ptr<const void> owner)
+                : std::istream(nullptr), owner_(std::move(owner)), buffer_(data) {
+                rdbuf(&buffer_);
+            }
+
+        private:
+            std::shared_ptr<const void> owner_;
+            SpanStreamBuf buffer_;
+        };
+
+    } // namespace
+
+    ArchiveFile::ArchiveFile(std::string_view path,
         std::uint64_t offset,
         std::uint64_t size,
         const std::byte* archive_data,
         std::size_t cache_threshold,
-        bool allow_streaming)
-        : path_(std::move(path))
+        bool allow_streaming,
+        std::uint32_t align,
+        std::shared_ptr<const void> data_owner)
+        : path_(path)
         , offset_(offset)
         , size_(size)
+        , align_(align)
         , archive_data_(archive_data)
+        , data_owner_(std::move(data_owner))
         , cache_threshold_(cache_threshold)
         , supports_streaming_(allow_streaming&& size_ > cache_threshold_) {
 
         //       
         if (supports_streaming_) {
-            stream_factory_ = [this]() -> std::shared_ptr<std::istream> {
-                //       
-                auto data_span = std::span<const std::byte>(archive_data_ + offset_, size_);
-                auto ss = std::make_shared<std::stringstream>();
-                ss->write(reinterpret_cast<const char*>(data_span.data()), data_span.size());
-                ss->seekg(0);
-                return ss;
+            // By value, not through this: a moved file takes the factory along
+            stream_factory_ = [data = raw_data(), owner = data_owner_]() -> std::shared_ptr<std::istream> {
+                // Reads straight out of the mapping, nothing is copied
+                return std::make_shared<SpanStream>(data, owner);
                 };
         }
     }
@@ -38,18 +89,21 @@ namespace RPFL {
     }
 
     ArchiveFile::ArchiveFile(ArchiveFile&& other) noexcept
-        : path_(std::move(other.path_))
+        : path_(other.path_)
         , offset_(other.offset_)
         , size_(other.size_)
+        , align_(other.align_)
         , archive_data_(other.archive_data_)
+        , data_owner_(std::move(other.data_owner_))
         , cache_threshold_(other.cache_threshold_)
         , data_holder_(std::move(other.data_holder_))
-        , is_loaded_(other.is_loaded_)
+        , load_state_(other.load_state_.load(std::memory_order_acquire))
         , supports_streaming_(other.supports_streaming_)
-        , stream_factory_(std::move(other.stream_factory_)) {
+        , stream_factory_(std::move(other.stream_factory_))
+        , trace_(other.trace_) {
 
         other.archive_data_ = nullptr;
-        other.is_loaded_ = false;
+        other.load_state_.store(Unloaded, std::memory_order_release);
         other.supports_streaming_ = false;
     }
 
@@ -57,35 +111,70 @@ namespace RPFL {
         if (this != &other) {
             release_cache();
 
-            path_ = std::move(other.path_);
+            path_ = other.path_;
             offset_ = other.offset_;
             size_ = other.size_;
+            align_ = other.align_;
             archive_data_ = other.archive_data_;
+            data_owner_ = std::move(other.data_owner_);
             cache_threshold_ = other.cache_threshold_;
             data_holder_ = std::move(other.data_holder_);
-            is_loaded_ = other.is_loaded_;
+            load_state_.store(other.load_state_.load(std::memory_order_acquire), std::memory_order_release);
             supports_streaming_ = other.supports_streaming_;
             stream_factory_ = std::move(other.stream_factory_);
+            trace_ = other.trace_;
 
             other.archive_data_ = nullptr;
-            other.is_loaded_ = false;
+            other.load_state_.store(Unloaded, std::memory_order_release);
             other.supports_streaming_ = false;
         }
         return *this;
     }
 
     void ArchiveFile::ensure_loaded() {
-        if (is_loaded_) {
+        if (load_state_.load(std::memory_order_acquire) == Loaded) {
+            return;
+        }
+
+        std::uint8_t expected = Unloaded;
+        if (!load_state_.compare_exchange_strong(expected, Loading, std::memory_order_acq_rel)) {
+            // Another thread is loading, the holder is ready once it stores Loaded
+            while (expected != Loaded) {
+                load_state_.wait(expected, std::memory_order_acquire);
+                expected = load_state_.load(std::memory_order_acquire);
+                if (expected == Unloaded) {
+                    // The loader failed, try again ourselves
+                    ensure_loaded();
+                    return;
+                }
+            }
             return;
         }
 
+        try {
+            load_holder();
+        }
+        catch (...) {
+            load_state_.store(Unloaded, std::memory_order_release);
+            load_state_.notify_all();
+            throw;
+        }
+        load_state_.store(Loaded, std::memory_order_release);
+        load_state_.notify_all();
+    }
+
+    void ArchiveFile::load_holder() {
         const std::byte* file_data = archive_data_ + offset_;
+        detail::count(detail::Loads);
 
         if (size_ <= cache_threshold_) {
             //   
             auto buffer = std::make_unique<std::byte[]>(size_);
             std::memcpy(buffer.get(), file_data, size_);
             data_holder_ = CachedData{ std::move(buffer), size_ };
+            detail::count(detail::CacheFills);
+            detail::count(detail::BytesCopied, size_);
+            detail::count(detail::BytesCacheFilled, size_);
         }
         else if (supports_streaming_) {
             //      
@@ -96,11 +185,20 @@ namespace RPFL {
             //      mmap (  )
             data_holder_ = MappedView{ std::span<const std::byte>(file_data, size_) };
         }
-
-        is_loaded_ = true;
     }
 
     std::span<const std::byte> ArchiveFile::data() {
+        LatencyOp op = touch_op();
+        detail::LatencyScope latency(op);
+        if (trace_) {
+            trace_->record(TraceOp::Data, path_, 0, size_);
+        }
+        auto span = load_data();
+        touch_pages(op);
+        return span;
+    }
+
+    std::span<const std::byte> ArchiveFile::load_data() {
         ensure_loaded();
 
         return std::visit([](auto&& holder) -> std::span<const std::byte> {
@@ -128,52 +226,38 @@ namespace RPFL {
     }
 
     std::string_view ArchiveFile::as_string_view() {
-        auto span = data();
-        // ,    span (,   )
+        LatencyOp op = touch_op();
+        detail::LatencyScope latency(op);
+        if (trace_) {
+            trace_->record(TraceOp::Data, path_, 0, size_);
+        }
+        auto span = load_data();
+        touch_pages(op);
         if (span.empty() && std::holds_alternative<StreamData>(data_holder_)) {
-            //       
-            auto stream = open_stream();
-            if (!stream) return "";
-
-            std::stringstream ss;
-            ss << stream->rdbuf();
-            thread_local std::string cached_string;
-            cached_string = ss.str();
-            return cached_string;
+            // Streamed entries are viewed straight from the mapping
+            return { reinterpret_cast<const char*>(archive_data_ + offset_), static_cast<std::size_t>(size_) };
         }
         return { reinterpret_cast<const char*>(span.data()), span.size() };
     }
 
     std::shared_ptr<std::istream> ArchiveFile::open_stream() {
+        if (trace_) {
+            trace_->record(TraceOp::OpenStream, path_, 0, size_);
+        }
+        detail::count(detail::StreamOpens);
+        detail::LatencyScope latency(LatencyOp::StreamOpen);
+        return make_stream();
+    }
+
+    std::shared_ptr<std::istream> ArchiveFile::make_stream() {
         if (supports_streaming_) {
             return stream_factory_();
         }
 
-        //     ,   ,
-        //     
-        ensure_loaded();
-
-        return std::visit([](auto&& holder) -> std::shared_ptr<std::istream> {
-            using T = std::decay_t<decltype(holder)>;
-            if constexpr (std::is_same_v<T, StreamData>) {
-                return holder.stream;
-            }
-            else if constexpr (std::is_same_v<T, CachedData>) {
-                auto ss = std::make_shared<std::stringstream>();
-                ss->write(reinterpret_cast<const char*>(holder.buffer.get()), holder.size);
-                ss->seekg(0);
-                return ss;
-            }
-            else if constexpr (std::is_same_v<T, MappedView>) {
-                auto ss = std::make_shared<std::stringstream>();
-                ss->write(reinterpret_cast<const char*>(holder.data.data()), holder.data.size());
-                ss->seekg(0);
-                return ss;
-            }
-            else {
-                return nullptr;
-            }
-            }, data_holder_);
+        // The cache holds the same bytes as the mapping (see copy_range()),
+        // and a cache buffer would dangle after release_cache(): stream from
+        // the mapping, which the stream co-owns
+        return std::make_shared<SpanStream>(raw_data(), data_owner_);
     }
 
     std::vector<std::byte> ArchiveFile::read_chunk(std::size_t offset, std::size_t size) {
@@ -181,37 +265,65 @@ namespace RPFL {
             return {};
         }
 
-        size = std::min(size, size_ - offset);
+        detail::LatencyScope latency(LatencyOp::RangeRead);
+        size = std::min(size, static_cast<std::size_t>(size_ - offset));
+        if (trace_) {
+            trace_->record(TraceOp::ReadChunk, path_, offset, size);
+        }
         std::vector<std::byte> chunk(size);
+        copy_range(offset, chunk);
+        return chunk;
+    }
 
-        if (is_cached() || !supports_streaming_) {
-            //       
-            auto span = data();
-            if (offset < span.size()) {
-                size_t copy_size = std::min(size, span.size() - offset);
-                std::memcpy(chunk.data(), span.data() + offset, copy_size);
-            }
+    std::size_t ArchiveFile::read(std::size_t offset, std::span<std::byte> buffer) const noexcept {
+        if (offset >= size_) {
+            return 0;
         }
-        else {
-            //      
-            auto stream = open_stream();
-            if (!stream) return {};
 
-            stream->seekg(offset);
-            stream->read(reinterpret_cast<char*>(chunk.data()), size);
+        detail::LatencyScope latency(LatencyOp::RangeRead);
+        std::size_t size = std::min(buffer.size(), static_cast<std::size_t>(size_ - offset));
+        if (trace_) {
+            trace_->record(TraceOp::ReadChunk, path_, offset, size);
         }
+        copy_range(offset, buffer.first(size));
+        return size;
+    }
 
-        return chunk;
+    void ArchiveFile::copy_range(std::size_t offset, std::span<std::byte> out) const noexcept {
+        // Every holder has the same bytes as the mapping, so copy from there
+        // and leave the cache and streams alone
+        std::memcpy(out.data(), archive_data_ + offset_ + offset, out.size());
+        detail::count(detail::BytesCopied, out.size());
+    }
+
+    LatencyOp ArchiveFile::touch_op() const noexcept {
+        return load_state_.load(std::memory_order_relaxed) == Loaded ? LatencyOp::CachedData : LatencyOp::FirstTouch;
+    }
+
+    void ArchiveFile::touch_pages(LatencyOp op) const noexcept {
+        if (!latency_enabled() || op != LatencyOp::FirstTouch || !latency_touch_pages()
+            || !std::holds_alternative<MappedView>(data_holder_)) {
+            return;
+        }
+        // Smallest page size around, so every page gets read
+        constexpr std::size_t kPage = 4096;
+        const volatile std::byte* data = archive_data_ + offset_;
+        for (std::uint64_t i = 0; i < size_; i += kPage) {
+            static_cast<void>(data[i]);
+        }
     }
 
     bool ArchiveFile::is_cached() const noexcept {
-        return std::holds_alternative<CachedData>(data_holder_);
+        return load_state_.load(std::memory_order_acquire) == Loaded
+            && std::holds_alternative<CachedData>(data_holder_);
     }
 
     void ArchiveFile::release_cache() noexcept {
         if (is_cached()) {
+            detail::count(detail::CacheEvictions);
+            detail::count(detail::BytesEvicted, std::get<CachedData>(data_holder_).size);
             data_holder_ = MappedView{ std::span<const std::byte>() };
-            is_loaded_ = false;
+            load_state_.store(Unloaded, std::memory_order_release);
         }
     }
 
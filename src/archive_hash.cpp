@@ -0,0 +1,135 @@
+#include "archive_hash.hpp"
+#include "archive_common.hpp"
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#define RPFL_CRC_X86 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define RPFL_CRC_ARM 1
+#endif
+
+namespace RPFL {
+
+    namespace {
+
+        constexpr std::uint32_t kPolynomial = 0x82F63B78; // reflected Castagnoli
+
+        using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+        constexpr Tables make_tables() {
+            Tables tables{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+                }
+                tables[0][i] = crc;
+            }
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                for (std::size_t t = 1; t < 8; ++t) {
+                    std::uint32_t prev = tables[t - 1][i];
+                    tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+                }
+            }
+            return tables;
+        }
+
+        constexpr Tables kTables = make_tables();
+
+        std::uint32_t crc32c_software(const unsigned char* p, std::size_t n, std::uint32_t crc) noexcept {
+            while (n >= 8) {
+                std::uint32_t lo;
+                std::uint32_t hi;
+                std::memcpy(&lo, p, 4);
+                std::memcpy(&hi, p + 4, 4);
+                if constexpr (std::endian::native == std::endian::big) {
+                    lo = byteswap(lo);
+                    hi = byteswap(hi);
+                }
+                lo ^= crc;
+                crc = kTables[7][lo & 0xFF] ^ kTables[6][(lo >> 8) & 0xFF]
+                    ^ kTables[5][(lo >> 16) & 0xFF] ^ kTables[4][lo >> 24]
+                    ^ kTables[3][hi & 0xFF] ^ kTables[2][(hi >> 8) & 0xFF]
+                    ^ kTables[1][(hi >> 16) & 0xFF] ^ kTables[0][hi >> 24];
+                p += 8;
+                n -= 8;
+            }
+            while (n--) {
+                crc = (crc >> 8) ^ kTables[0][(crc ^ *p++) & 0xFF];
+            }
+            return crc;
+        }
+
+#if defined(RPFL_CRC_X86)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((target("sse4.2")))
+#endif
+        std::uint32_t crc32c_hardware(const unsigned char* p, std::size_t n, std::uint32_t crc) noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+            std::uint64_t crc64 = crc;
+            while (n >= 8) {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                crc64 = _mm_crc32_u64(crc64, word);
+                p += 8;
+                n -= 8;
+            }
+            crc = static_cast<std::uint32_t>(crc64);
+#endif
+            while (n--) {
+                crc = _mm_crc32_u8(crc, *p++);
+            }
+            return crc;
+        }
+
+        bool has_hardware_crc() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_cpu_supports("sse4.2");
+#else
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+#endif
+        }
+#elif defined(RPFL_CRC_ARM)
+        std::uint32_t crc32c_hardware(const unsigned char* p, std::size_t n, std::uint32_t crc) noexcept {
+            while (n >= 8) {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                crc = __crc32cd(crc, word);
+                p += 8;
+                n -= 8;
+            }
+            while (n--) {
+                crc = __crc32cb(crc, *p++);
+            }
+            return crc;
+        }
+
+        bool has_hardware_crc() noexcept {
+            return true;
+        }
+#endif
+
+    } // namespace
+
+    std::uint32_t crc32c(std::span<const std::byte> data, std::uint32_t crc) noexcept {
+        auto p = reinterpret_cast<const unsigned char*>(data.data());
+        crc = ~crc;
+#if defined(RPFL_CRC_X86) || defined(RPFL_CRC_ARM)
+        static const bool hardware = has_hardware_crc();
+        if (hardware) {
+            return ~crc32c_hardware(p, data.size(), crc);
+        }
+#endif
+        return ~crc32c_software(p, data.size(), crc);
+    }
+
+} // namespace RPFL
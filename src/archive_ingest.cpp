@@ -0,0 +1,219 @@
+#include "archive_writer.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace RPFL {
+
+    namespace {
+
+        struct IngestItem {
+            std::filesystem::path file;
+            std::string archive_path;
+            std::uint64_t size = 0;
+            bool streamed = false;
+            std::vector<std::byte> data;
+            std::optional<std::string> error;
+            bool reserved = false; // holds size bytes of the in-flight budget
+            bool done = false;
+        };
+
+        void read_item(IngestItem& item) {
+            std::ifstream file(item.file, std::ios::binary);
+            if (!file) {
+                item.error = "Failed to open file for reading";
+                return;
+            }
+
+            item.data.resize(static_cast<std::size_t>(item.size));
+            file.read(reinterpret_cast<char*>(item.data.data()), static_cast<std::streamsize>(item.size));
+            if (static_cast<std::uint64_t>(file.gcount()) != item.size || file.peek() != std::ifstream::traits_type::eof()) {
+                item.error = "File changed size while being read";
+                item.data = {};
+            }
+        }
+
+    } // namespace
+
+    IngestReport ArchiveWriter::add_files_from_directory(const std::filesystem::path& dir,
+        const std::string& prefix,
+        std::function<bool(const std::filesystem::path&)> filter) {
+        IngestOptions options;
+        options.filter = std::move(filter);
+        return add_files_from_directory(dir, prefix, options);
+    }
+
+    IngestReport ArchiveWriter::add_files_from_directory(const std::filesystem::path& dir,
+        const std::string& prefix, const IngestOptions& options) {
+        IngestReport report;
+        std::error_code error;
+        if (!std::filesystem::is_directory(dir, error)) {
+            report.errors.push_back({ dir, "Not a directory" });
+            return report;
+        }
+
+        // Walk first, the catalog order must not depend on the file system;
+        // stat and read happen on the pool
+        std::vector<IngestItem> items;
+        auto options_flags = std::filesystem::directory_options::skip_permission_denied;
+        for (auto it = std::filesystem::recursive_directory_iterator(dir, options_flags, error);
+            !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_regular_file(error)) {
+                continue;
+            }
+            if (options.filter && !options.filter(it->path())) {
+                continue;
+            }
+
+            IngestItem item;
+            item.file = it->path();
+            item.archive_path = prefix + it->path().lexically_relative(dir).string();
+            std::replace(item.archive_path.begin(), item.archive_path.end(), '\\', '/');
+            items.push_back(std::move(item));
+        }
+        if (error) {
+            report.errors.push_back({ dir, error.message() });
+        }
+        std::ranges::sort(items, {}, &IngestItem::archive_path);
+
+        // Workers take files in order, stat them in parallel, then reserve
+        // their bytes in that same order, so whatever holds the budget is
+        // ahead of the consumer and the file it waits for can always get read
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t next_reservation = 0;
+        std::uint64_t in_flight = 0;
+        bool stop = false;
+        // First exception out of a worker (bad_alloc sizing a buffer, ...),
+        // rethrown by the consumer instead of escaping the thread
+        std::exception_ptr failure;
+        std::atomic<std::size_t> next_item{ 0 };
+
+        auto ingest = [&] {
+            for (std::size_t i = next_item++; i < items.size(); i = next_item++) {
+                IngestItem& item = items[i];
+                std::error_code stat_error;
+                item.size = std::filesystem::file_size(item.file, stat_error);
+                if (stat_error) {
+                    item.size = 0;
+                    item.error = stat_error.message();
+                }
+                else {
+                    item.streamed = options.stream_threshold > 0 && item.size >= options.stream_threshold;
+                }
+
+                bool reads = !item.error && !item.streamed;
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&] {
+                        return stop || (next_reservation == i
+                            && (!reads || in_flight == 0 || in_flight + item.size <= options.max_in_flight_bytes));
+                    });
+                    if (stop) {
+                        return;
+                    }
+                    ++next_reservation;
+                    if (reads) {
+                        in_flight += item.size;
+                        item.reserved = true;
+                    }
+                }
+                changed.notify_all();
+
+                if (reads) {
+                    read_item(item);
+                }
+
+                {
+                    std::lock_guard lock(mutex);
+                    item.done = true;
+                }
+                changed.notify_all();
+            }
+        };
+        auto worker = [&] {
+            try {
+                ingest();
+            }
+            catch (...) {
+                {
+                    std::lock_guard lock(mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    stop = true;
+                }
+                changed.notify_all();
+            }
+        };
+
+        unsigned threads = static_cast<unsigned>(
+            std::min<std::size_t>(resolve_thread_count(options.threads), std::max<std::size_t>(items.size(), 1)));
+        std::vector<std::jthread> pool;
+        pool.reserve(threads);
+        try {
+            // Inside the try: if a thread can't start, the ones running must stop
+            for (unsigned i = 0; i < threads; ++i) {
+                pool.emplace_back(worker);
+            }
+
+            for (auto& item : items) {
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [&] { return item.done || failure; });
+                    if (!item.done) {
+                        std::rethrow_exception(failure);
+                    }
+                }
+
+                if (!item.error) {
+                    try {
+                        if (item.streamed) {
+                            if (!add_file_streamed(item.file, item.archive_path, options.alignment)) {
+                                throw IOError("Failed to stat file: " + item.file.string());
+                            }
+                        }
+                        else {
+                            FileEntry entry;
+                            entry.path = item.archive_path;
+                            entry.size = item.size;
+                            entry.data = std::move(item.data);
+                            add_entry(std::move(entry), options.alignment);
+                        }
+                        ++report.added;
+                        report.bytes += item.size;
+                    }
+                    catch (const ArchiveException& e) {
+                        item.error = e.what();
+                    }
+                }
+                if (item.error) {
+                    report.errors.push_back({ item.file, *item.error });
+                }
+
+                if (item.reserved) {
+                    std::lock_guard lock(mutex);
+                    in_flight -= item.size;
+                }
+                changed.notify_all();
+            }
+        }
+        catch (...) {
+            {
+                std::lock_guard lock(mutex);
+                stop = true;
+            }
+            changed.notify_all();
+            throw;
+        }
+
+        return report;
+    }
+
+} // namespace RPFL
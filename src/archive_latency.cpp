@@ -0,0 +1,262 @@
+#include "archive_latency.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace RPFL {
+
+    namespace {
+
+        constexpr const char* kOpNames[kLatencyOpCount] = {
+            "open", "lookup", "first_touch", "cached_data", "range_read", "stream_open"
+        };
+
+        std::atomic<bool> touch_pages_enabled{ false };
+
+        void append(std::string& out, const char* format, auto... args) {
+            char line[256];
+            int length = std::snprintf(line, sizeof(line), format, args...);
+            out.append(line, static_cast<std::size_t>(std::clamp(length, 0, static_cast<int>(sizeof(line) - 1))));
+        }
+
+    } // namespace
+
+    void set_latency_touch_pages(bool touch_pages) noexcept {
+        touch_pages_enabled.store(touch_pages, std::memory_order_relaxed);
+    }
+
+    bool latency_touch_pages() noexcept {
+        return touch_pages_enabled.load(std::memory_order_relaxed);
+    }
+
+    const char* to_string(LatencyOp op) noexcept {
+        std::size_t index = static_cast<std::size_t>(op);
+        return index < kLatencyOpCount ? kOpNames[index] : "unknown";
+    }
+
+    void LatencyHistogram::record(std::uint64_t ns) noexcept {
+        ++buckets_[bucket_index(ns)];
+        ++count_;
+        total_ns_ += ns;
+    }
+
+    void LatencyHistogram::add(std::size_t index, std::uint64_t count, std::uint64_t total_ns) noexcept {
+        buckets_[std::min(index, kBucketCount - 1)] += count;
+        count_ += count;
+        total_ns_ += total_ns;
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        total_ns_ += other.total_ns_;
+    }
+
+    void LatencyHistogram::subtract(const LatencyHistogram& earlier) noexcept {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            buckets_[i] -= std::min(buckets_[i], earlier.buckets_[i]);
+        }
+        count_ -= std::min(count_, earlier.count_);
+        total_ns_ -= std::min(total_ns_, earlier.total_ns_);
+    }
+
+    void LatencyHistogram::clear() noexcept {
+        buckets_.fill(0);
+        count_ = 0;
+        total_ns_ = 0;
+    }
+
+    double LatencyHistogram::mean() const noexcept {
+        return count_ > 0 ? static_cast<double>(total_ns_) / static_cast<double>(count_) : 0.0;
+    }
+
+    std::uint64_t LatencyHistogram::min() const noexcept {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            if (buckets_[i] != 0) {
+                return bucket_lower(i);
+            }
+        }
+        return 0;
+    }
+
+    std::uint64_t LatencyHistogram::max() const noexcept {
+        for (std::size_t i = kBucketCount; i-- > 0;) {
+            if (buckets_[i] != 0) {
+                return bucket_upper(i);
+            }
+        }
+        return 0;
+    }
+
+    std::uint64_t LatencyHistogram::percentile(double percent) const noexcept {
+        if (count_ == 0) {
+            return 0;
+        }
+        // Rank of the value at percent, 1-based, at least the first value
+        double fraction = std::clamp(percent, 0.0, 100.0) / 100.0;
+        std::uint64_t rank = std::max<std::uint64_t>(1,
+            static_cast<std::uint64_t>(fraction * static_cast<double>(count_) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                return bucket_upper(i);
+            }
+        }
+        return max();
+    }
+
+    void LatencySnapshot::merge(const LatencySnapshot& other) noexcept {
+        for (std::size_t i = 0; i < kLatencyOpCount; ++i) {
+            ops[i].merge(other.ops[i]);
+        }
+    }
+
+    void LatencySnapshot::subtract(const LatencySnapshot& earlier) noexcept {
+        for (std::size_t i = 0; i < kLatencyOpCount; ++i) {
+            ops[i].subtract(earlier.ops[i]);
+        }
+    }
+
+    std::string LatencySnapshot::to_text() const {
+        std::string out;
+        append(out, "%-12s %10s %10s %10s %10s %10s %10s %10s\n",
+            "op", "count", "mean ns", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+        for (std::size_t i = 0; i < kLatencyOpCount; ++i) {
+            const LatencyHistogram& h = ops[i];
+            append(out, "%-12s %10llu %10.0f %10llu %10llu %10llu %10llu %10llu\n", kOpNames[i],
+                static_cast<unsigned long long>(h.count()), h.mean(),
+                static_cast<unsigned long long>(h.percentile(50)),
+                static_cast<unsigned long long>(h.percentile(90)),
+                static_cast<unsigned long long>(h.percentile(99)),
+                static_cast<unsigned long long>(h.percentile(99.9)),
+                static_cast<unsigned long long>(h.max()));
+        }
+        return out;
+    }
+
+    std::string LatencySnapshot::to_json() const {
+        std::string out = "{";
+        for (std::size_t i = 0; i < kLatencyOpCount; ++i) {
+            const LatencyHistogram& h = ops[i];
+            append(out, "%s\n  \"%s\": {\"count\": %llu, \"mean_ns\": %.1f, \"min_ns\": %llu, "
+                "\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, \"buckets\": [",
+                i == 0 ? "" : ",", kOpNames[i], static_cast<unsigned long long>(h.count()), h.mean(),
+                static_cast<unsigned long long>(h.min()),
+                static_cast<unsigned long long>(h.percentile(50)),
+                static_cast<unsigned long long>(h.percentile(90)),
+                static_cast<unsigned long long>(h.percentile(99)),
+                static_cast<unsigned long long>(h.percentile(99.9)),
+                static_cast<unsigned long long>(h.max()));
+            bool first = true;
+            for (std::size_t b = 0; b < LatencyHistogram::kBucketCount; ++b) {
+                if (h.buckets()[b] != 0) {
+                    append(out, "%s[%llu, %llu]", first ? "" : ", ",
+                        static_cast<unsigned long long>(LatencyHistogram::bucket_upper(b)),
+                        static_cast<unsigned long long>(h.buckets()[b]));
+                    first = false;
+                }
+            }
+            out += "]}";
+        }
+        out += "\n}\n";
+        return out;
+    }
+
+#ifdef RPFL_ENABLE_LATENCY
+
+    namespace {
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<detail::LatencyBlock*> live;
+            LatencySnapshot retired; // from threads that have exited
+            LatencySnapshot base;    // totals at the last reset
+        };
+
+        // Never destroyed: thread_local blocks may retire after static
+        // destructors have run
+        Registry& registry() {
+            static Registry* instance = new Registry;
+            return *instance;
+        }
+
+        void add_block(LatencySnapshot& totals, const detail::LatencyBlock& block) {
+            for (std::size_t op = 0; op < kLatencyOpCount; ++op) {
+                auto& histogram = totals.ops[op];
+                for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+                    histogram.add(i, block.buckets[op][i].load(std::memory_order_relaxed), 0);
+                }
+                histogram.add(0, 0, block.total_ns[op].load(std::memory_order_relaxed));
+            }
+        }
+
+        std::unique_ptr<LatencySnapshot> totals_locked(const Registry& reg) {
+            auto totals = std::make_unique<LatencySnapshot>(reg.retired);
+            for (const auto* block : reg.live) {
+                add_block(*totals, *block);
+            }
+            return totals;
+        }
+
+    } // namespace
+
+    namespace detail {
+
+        LatencyBlock::LatencyBlock() noexcept {
+            try {
+                Registry& reg = registry();
+                std::lock_guard lock(reg.mutex);
+                reg.live.push_back(this);
+                registered = true;
+            }
+            catch (const std::exception&) {
+                // bad_alloc, or system_error from the mutex
+            }
+        }
+
+        LatencyBlock::~LatencyBlock() {
+            if (!registered) {
+                return;
+            }
+            Registry& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            add_block(reg.retired, *this);
+            reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+        }
+
+    } // namespace detail
+
+    LatencySnapshot latency() {
+        Registry& reg = registry();
+        std::unique_ptr<LatencySnapshot> totals;
+        {
+            std::lock_guard lock(reg.mutex);
+            totals = totals_locked(reg);
+            totals->subtract(reg.base);
+        }
+        return *totals;
+    }
+
+    void reset_latency() {
+        Registry& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.base = *totals_locked(reg);
+    }
+
+#else
+
+    LatencySnapshot latency() {
+        return {};
+    }
+
+    void reset_latency() {}
+
+#endif
+
+} // namespace RPFL
@@ -0,0 +1,114 @@
+#include "archive_manifest.hpp"
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+namespace RPFL {
+
+    namespace {
+
+        template<typename T>
+        T parse_number(std::string_view& line, int base = 10) {
+            T value{};
+            auto [end, ec] = std::from_chars(line.data(), line.data() + line.size(), value, base);
+            if (ec != std::errc() || end == line.data() + line.size() || *end != ' ') {
+                throw ArchiveFormatException("Malformed manifest entry");
+            }
+            line.remove_prefix(static_cast<std::size_t>(end - line.data()) + 1);
+            return value;
+        }
+
+    } // namespace
+
+    std::uint64_t ArchiveManifest::line_size(std::size_t path_size, std::uint64_t offset,
+        std::uint64_t size, std::uint32_t align) noexcept {
+        auto digits = [](std::uint64_t value) {
+            std::uint64_t count = 1;
+            while (value >= 10) {
+                value /= 10;
+                ++count;
+            }
+            return count;
+        };
+        // crc, three numbers and the path, separated by spaces, then '\n'
+        return 8 + 1 + digits(offset) + 1 + digits(size) + 1 + digits(align) + 1 + path_size + 1;
+    }
+
+    void ArchiveManifest::add(Entry entry) {
+        if (entry.path.find('\n') != std::string::npos) {
+            throw ArchiveException(std::format("Manifest can't store path '{}'", entry.path));
+        }
+        index_.try_emplace(entry.path, entries_.size());
+        entries_.push_back(std::move(entry));
+    }
+
+    void ArchiveManifest::clear() noexcept {
+        entries_.clear();
+        index_.clear();
+    }
+
+    const ArchiveManifest::Entry* ArchiveManifest::find(std::string_view path) const noexcept {
+        auto it = index_.find(path);
+        return it == index_.end() ? nullptr : &entries_[it->second];
+    }
+
+    std::string ArchiveManifest::to_string() const {
+        std::string text(kHeader);
+        text += '\n';
+        for (const auto& entry : entries_) {
+            text += std::format("{:08x} {} {} {} {}\n",
+                entry.crc32c, entry.offset, entry.size, entry.align, entry.path);
+        }
+        return text;
+    }
+
+    ArchiveManifest ArchiveManifest::parse(std::string_view text) {
+        auto next_line = [&text]() {
+            std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            return line;
+        };
+
+        if (next_line() != kHeader) {
+            throw ArchiveFormatException("Unknown manifest header");
+        }
+
+        ArchiveManifest manifest;
+        while (!text.empty()) {
+            std::string_view line = next_line();
+            Entry entry;
+            entry.crc32c = parse_number<std::uint32_t>(line, 16);
+            entry.offset = parse_number<std::uint64_t>(line);
+            entry.size = parse_number<std::uint64_t>(line);
+            entry.align = parse_number<std::uint32_t>(line);
+            entry.path = line;
+            manifest.add(std::move(entry));
+        }
+        return manifest;
+    }
+
+    void ArchiveManifest::save(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw IOError("Failed to open file for writing: " + filepath);
+        }
+        std::string text = to_string();
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file) {
+            throw IOError("Failed to write manifest: " + filepath);
+        }
+    }
+
+    ArchiveManifest ArchiveManifest::load(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw IOError("Failed to open file: " + filepath);
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return parse(ss.str());
+    }
+
+} // namespace RPFL
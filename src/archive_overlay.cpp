@@ -0,0 +1,116 @@
+#include "archive_overlay.hpp"
+#include <algorithm>
+
+namespace RPFL {
+
+    ArchiveOverlay::MountId ArchiveOverlay::mount(std::shared_ptr<ArchiveReader> reader,
+        int priority) {
+        if (!reader || !reader->is_open()) {
+            throw ArchiveException("Cannot mount an archive that is not open");
+        }
+
+        MountId id = next_id_++;
+
+        // Keep mounts sorted by rank: higher priority first, newer first on ties
+        auto pos = std::find_if(mounts_.begin(), mounts_.end(),
+            [priority](const Mount& m) { return m.priority <= priority; });
+        ArchiveReader* raw_reader = reader.get();
+        mounts_.insert(pos, Mount{ id, priority, std::move(reader) });
+
+        index_.reserve(index_.size() + raw_reader->file_count());
+        for (const auto& file : raw_reader->files()) {
+            Entry entry{ file.get(), raw_reader, id, priority };
+            auto [it, inserted] = index_.try_emplace(file->path(), entry);
+            if (!inserted && outranks(entry, it->second)) {
+                set_winner(it, entry);
+            }
+        }
+        return id;
+    }
+
+    bool ArchiveOverlay::unmount(MountId id) {
+        auto mount_it = find_mount(id);
+        if (mount_it == mounts_.end()) {
+            return false;
+        }
+
+        std::shared_ptr<ArchiveReader> reader = mount_it->reader;
+        mounts_.erase(mount_it);
+
+        // Only paths won by this mount need to fall back to the next archive
+        for (const auto& file : reader->files()) {
+            auto it = index_.find(file->path());
+            if (it == index_.end() || it->second.mount != id) {
+                continue;
+            }
+
+            bool replaced = false;
+            for (const auto& m : mounts_) {
+                if (ArchiveFile* next = m.reader->find(file->path())) {
+                    set_winner(it, Entry{ next, m.reader.get(), m.id, m.priority });
+                    replaced = true;
+                    break;
+                }
+            }
+            if (!replaced) {
+                index_.erase(it);
+            }
+        }
+        return true;
+    }
+
+    void ArchiveOverlay::clear() noexcept {
+        index_.clear();
+        mounts_.clear();
+    }
+
+    const ArchiveOverlay::Entry* ArchiveOverlay::find(std::string_view path) const noexcept {
+        auto it = index_.find(path);
+        return it == index_.end() ? nullptr : &it->second;
+    }
+
+    bool ArchiveOverlay::contains(std::string_view path) const noexcept {
+        return index_.find(path) != index_.end();
+    }
+
+    ArchiveFile& ArchiveOverlay::get_file(std::string_view path) const {
+        const Entry* entry = find(path);
+        if (!entry) {
+            throw FileNotFoundException(std::string(path));
+        }
+        return *entry->file;
+    }
+
+    std::span<const std::byte> ArchiveOverlay::read_raw(std::string_view path) const {
+        return get_file(path).raw_data();
+    }
+
+    std::shared_ptr<ArchiveReader> ArchiveOverlay::reader(MountId id) const noexcept {
+        auto it = find_mount(id);
+        return it == mounts_.end() ? nullptr : it->reader;
+    }
+
+    std::vector<ArchiveOverlay::Mount>::const_iterator
+        ArchiveOverlay::find_mount(MountId id) const noexcept {
+        return std::find_if(mounts_.begin(), mounts_.end(),
+            [id](const Mount& m) { return m.id == id; });
+    }
+
+    bool ArchiveOverlay::outranks(const Entry& a, const Entry& b) noexcept {
+        // Mount ids only grow, so a larger id means a newer mount
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        return a.mount > b.mount;
+    }
+
+    void ArchiveOverlay::set_winner(std::unordered_map<std::string_view, Entry>::iterator it,
+        const Entry& entry) {
+        // The key views the winner's path, so re-key it together with the entry
+        auto node = index_.extract(it);
+        node.key() = entry.file->path();
+        node.mapped() = entry;
+        index_.insert(std::move(node));
+    }
+
+} // namespace RPFL
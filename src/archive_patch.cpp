@@ -0,0 +1,560 @@
+#include "archive_patch.hpp"
+#include "archive_diff.hpp"
+#include "archive_hash.hpp"
+#include "archive_writer.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace RPFL {
+
+    namespace {
+
+        // Patch layout, all integers are LEB128 varints unless noted:
+        //   "RPFLPAT1" identifier version endianness(u8) entry_count
+        //   per entry: path size align crc32c(u32 LE) op [old_path old_size] [body_size]
+        //   then the bodies of Literal and Delta entries, in entry order
+        // A delta body is a list of instructions:
+        //   'C' old_offset length    copy from the old entry
+        //   'I' length bytes         insert literal bytes
+        constexpr std::array<char, 8> kPatchMagic{ 'R', 'P', 'F', 'L', 'P', 'A', 'T', '1' };
+        constexpr std::byte kCopyOp{ 'C' };
+        constexpr std::byte kInsertOp{ 'I' };
+        constexpr std::size_t kMaxBlocks = 1 << 20;
+        constexpr std::size_t kMaxCandidates = 8;
+        constexpr std::size_t kChunkSize = 64 * 1024;
+
+        enum class PatchOp : std::uint8_t {
+            Copy,    // same bytes as an old entry
+            Literal, // whole data in the patch
+            Delta    // old entry plus delta instructions
+        };
+
+        void put_varint(std::vector<std::byte>& out, std::uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<std::byte>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<std::byte>(value));
+        }
+
+        void put_string(std::vector<std::byte>& out, std::string_view text) {
+            put_varint(out, text.size());
+            auto bytes = std::as_bytes(std::span(text));
+            out.insert(out.end(), bytes.begin(), bytes.end());
+        }
+
+        // Polynomial hash over a block, rolled one byte at a time (mod 2^32)
+        constexpr std::uint32_t kHashBase = 0x01000193;
+
+        std::uint32_t block_hash(const std::byte* data, std::size_t size) noexcept {
+            std::uint32_t hash = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                hash = hash * kHashBase + static_cast<std::uint8_t>(data[i]);
+            }
+            return hash;
+        }
+
+        class DeltaEncoder {
+        public:
+            DeltaEncoder(std::span<const std::byte> source, std::size_t block_size)
+                : source_(source), block_size_(block_size) {
+                block_size_ = std::max(block_size_, source.size() / kMaxBlocks + 1);
+
+                std::size_t blocks = source.size() / block_size_;
+                index_.reserve(blocks);
+                for (std::size_t i = 0; i < blocks; ++i) {
+                    std::uint64_t offset = static_cast<std::uint64_t>(i) * block_size_;
+                    index_.push_back({ block_hash(source.data() + offset, block_size_), offset });
+                }
+                std::ranges::sort(index_, {}, &Block::hash);
+
+                out_power_ = 1;
+                for (std::size_t i = 1; i < block_size_; ++i) {
+                    out_power_ *= kHashBase;
+                }
+            }
+
+            // Instructions rebuilding target from the source, or nothing once
+            // they grow past limit bytes
+            std::optional<std::vector<std::byte>> encode(std::span<const std::byte> target,
+                std::size_t limit) const {
+                std::vector<std::byte> out;
+                std::size_t literal_start = 0;
+                std::size_t pos = 0;
+                const std::size_t size = target.size();
+                std::uint32_t hash = 0;
+                if (!index_.empty() && size >= block_size_) {
+                    hash = block_hash(target.data(), block_size_);
+                }
+
+                while (!index_.empty() && pos + block_size_ <= size) {
+                    std::uint64_t match_offset = 0;
+                    std::size_t match_length = 0;
+                    auto [first, last] = std::ranges::equal_range(index_, hash, {}, &Block::hash);
+                    for (std::size_t n = 0; first != last && n < kMaxCandidates; ++first, ++n) {
+                        std::size_t length = match_forward(first->offset, target, pos);
+                        if (length >= block_size_ && length > match_length) {
+                            match_offset = first->offset;
+                            match_length = length;
+                        }
+                    }
+
+                    if (match_length == 0) {
+                        if (pos + block_size_ == size) {
+                            break;
+                        }
+                        hash = (hash - static_cast<std::uint8_t>(target[pos]) * out_power_) * kHashBase
+                            + static_cast<std::uint8_t>(target[pos + block_size_]);
+                        ++pos;
+                        continue;
+                    }
+
+                    // Grow the match backwards over bytes still pending as literal
+                    while (pos > literal_start && match_offset > 0
+                        && source_[match_offset - 1] == target[pos - 1]) {
+                        --pos;
+                        --match_offset;
+                        ++match_length;
+                    }
+
+                    emit_insert(out, target.subspan(literal_start, pos - literal_start));
+                    out.push_back(kCopyOp);
+                    put_varint(out, match_offset);
+                    put_varint(out, match_length);
+                    if (out.size() > limit) {
+                        return std::nullopt;
+                    }
+
+                    pos += match_length;
+                    literal_start = pos;
+                    if (pos + block_size_ <= size) {
+                        hash = block_hash(target.data() + pos, block_size_);
+                    }
+                }
+
+                emit_insert(out, target.subspan(literal_start));
+                if (out.size() > limit) {
+                    return std::nullopt;
+                }
+                return out;
+            }
+
+        private:
+            struct Block {
+                std::uint32_t hash;
+                std::uint64_t offset;
+            };
+
+            std::size_t match_forward(std::uint64_t offset, std::span<const std::byte> target,
+                std::size_t pos) const noexcept {
+                std::size_t limit = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(source_.size() - offset, target.size() - pos));
+                if (limit < block_size_
+                    || std::memcmp(source_.data() + offset, target.data() + pos, block_size_) != 0) {
+                    return 0;
+                }
+                std::size_t length = block_size_;
+                while (length < limit && source_[offset + length] == target[pos + length]) {
+                    ++length;
+                }
+                return length;
+            }
+
+            static void emit_insert(std::vector<std::byte>& out, std::span<const std::byte> bytes) {
+                if (bytes.empty()) {
+                    return;
+                }
+                out.push_back(kInsertOp);
+                put_varint(out, bytes.size());
+                out.insert(out.end(), bytes.begin(), bytes.end());
+            }
+
+            std::span<const std::byte> source_;
+            std::size_t block_size_;
+            std::vector<Block> index_;
+            std::uint32_t out_power_ = 1;
+        };
+
+        struct PlannedEntry {
+            const ArchiveFile* file = nullptr;
+            const ArchiveFile* base = nullptr; // old entry for Copy and Delta
+            PatchOp op = PatchOp::Literal;
+            std::uint32_t crc32c = 0;
+            std::vector<std::byte> delta;
+        };
+
+        void write_bytes(std::ostream& out, std::span<const std::byte> bytes) {
+            out.write(reinterpret_cast<const char*>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size()));
+            if (!out) {
+                throw IOError("Failed to write patch data");
+            }
+        }
+
+        // Sequential reader over the patch stream that counts what it consumed
+        class PatchInput {
+        public:
+            explicit PatchInput(std::istream& in) : in_(in), buffer_(kChunkSize) {}
+
+            void read(void* data, std::size_t size) {
+                in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+                if (static_cast<std::size_t>(in_.gcount()) != size) {
+                    throw ArchiveFormatException("Patch is truncated");
+                }
+                consumed_ += size;
+            }
+
+            std::uint8_t byte() {
+                std::uint8_t value;
+                read(&value, 1);
+                return value;
+            }
+
+            std::uint64_t varint() {
+                std::uint64_t value = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7) {
+                    std::uint8_t b = byte();
+                    value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                    if ((b & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw ArchiveFormatException("Malformed varint in patch");
+            }
+
+            std::string string() {
+                std::uint64_t size = varint();
+                if (size > kChunkSize) {
+                    throw ArchiveFormatException("Path in patch is too long");
+                }
+                std::string text(static_cast<std::size_t>(size), '\0');
+                read(text.data(), text.size());
+                return text;
+            }
+
+            // Passes size bytes of the patch to sink through a fixed buffer
+            void stream(std::uint64_t size, const ArchiveWriter::ChunkSink& sink) {
+                while (size > 0) {
+                    std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(size, buffer_.size()));
+                    read(buffer_.data(), n);
+                    sink(std::span<const std::byte>(buffer_.data(), n));
+                    size -= n;
+                }
+            }
+
+            std::uint64_t consumed() const noexcept { return consumed_; }
+            bool at_end() { return in_.peek() == std::istream::traits_type::eof(); }
+
+        private:
+            std::istream& in_;
+            std::vector<std::byte> buffer_;
+            std::uint64_t consumed_ = 0;
+        };
+
+        struct PatchEntry {
+            std::string path;
+            std::uint64_t size = 0;
+            std::uint32_t align = 1;
+            std::uint32_t crc32c = 0;
+            PatchOp op = PatchOp::Literal;
+            const ArchiveFile* base = nullptr;
+            std::uint64_t body_size = 0;
+        };
+
+        void apply_delta(PatchInput& input, std::uint64_t body_size, std::span<const std::byte> base,
+            const ArchiveWriter::ChunkSink& sink) {
+            std::uint64_t end = input.consumed() + body_size;
+            while (input.consumed() < end) {
+                std::byte op{ input.byte() };
+                std::uint64_t first = op == kCopyOp ? input.varint() : 0;
+                std::uint64_t length = input.varint();
+                if (op == kCopyOp) {
+                    if (first > base.size() || length > base.size() - first) {
+                        throw ArchiveFormatException("Patch copies past the end of the old entry");
+                    }
+                    sink(base.subspan(static_cast<std::size_t>(first), static_cast<std::size_t>(length)));
+                }
+                else if (op == kInsertOp) {
+                    input.stream(length, sink);
+                }
+                else {
+                    throw ArchiveFormatException("Unknown delta instruction in patch");
+                }
+            }
+            if (input.consumed() != end) {
+                throw ArchiveFormatException("Delta overruns its declared size");
+            }
+        }
+
+    } // namespace
+
+    PatchStats create_patch(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        std::ostream& patch, const PatchOptions& options) {
+        using Change = ArchiveDiff::Change;
+
+        DiffOptions diff_options;
+        diff_options.threads = options.threads;
+        diff_options.include_unchanged = true;
+        ArchiveDiff changes = diff(old_archive, new_archive, diff_options);
+
+        std::unordered_map<const ArchiveFile*, const ArchiveDiff::Entry*> by_new_file;
+        for (const auto& entry : changes.entries) {
+            if (entry.new_file) {
+                by_new_file.emplace(entry.new_file, &entry);
+            }
+        }
+
+        // Archive order, so the applier can stream entries straight through the writer
+        std::vector<PlannedEntry> plan;
+        plan.reserve(new_archive.file_count());
+        for (const auto& file : new_archive.files()) {
+            PlannedEntry planned;
+            planned.file = file.get();
+            const ArchiveDiff::Entry* change = by_new_file.at(file.get());
+            if (change->change == Change::Unchanged || change->change == Change::Moved) {
+                planned.op = PatchOp::Copy;
+                planned.base = change->old_file;
+            }
+            else if (change->change == Change::Changed) {
+                planned.op = PatchOp::Delta;
+                planned.base = change->old_file;
+            }
+            plan.push_back(std::move(planned));
+        }
+
+        // Old entries anything not yet copied could duplicate, keyed by size;
+        // only the sizes still wanted are hashed
+        std::unordered_set<std::uint64_t> wanted_sizes;
+        for (const auto& planned : plan) {
+            if (planned.op != PatchOp::Copy) {
+                wanted_sizes.insert(planned.file->size());
+            }
+        }
+        std::vector<const ArchiveFile*> candidates;
+        for (const auto& file : old_archive.files()) {
+            if (wanted_sizes.contains(file->size())) {
+                candidates.push_back(file.get());
+            }
+        }
+        std::vector<std::uint32_t> candidate_crcs(candidates.size());
+        parallel_for(candidates.size(), options.threads, [&](std::size_t i) {
+            candidate_crcs[i] = crc32c(candidates[i]->raw_data());
+        });
+        std::unordered_multimap<std::uint64_t, std::size_t> candidates_by_size;
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            candidates_by_size.emplace(candidates[i]->size(), i);
+        }
+
+        parallel_for(plan.size(), options.threads, [&](std::size_t i) {
+            PlannedEntry& planned = plan[i];
+            auto data = planned.file->raw_data();
+            planned.crc32c = crc32c(data);
+            if (planned.op == PatchOp::Copy) {
+                return;
+            }
+
+            // Same bytes still present elsewhere in the old archive
+            auto [first, last] = candidates_by_size.equal_range(data.size());
+            for (; first != last; ++first) {
+                const ArchiveFile* candidate = candidates[first->second];
+                if (candidate_crcs[first->second] == planned.crc32c
+                    && std::ranges::equal(candidate->raw_data(), data)) {
+                    planned.op = PatchOp::Copy;
+                    planned.base = candidate;
+                    return;
+                }
+            }
+            if (planned.op != PatchOp::Delta) {
+                return;
+            }
+
+            // Keep the delta only if it beats shipping the data itself
+            DeltaEncoder encoder(planned.base->raw_data(), std::max<std::size_t>(options.block_size, 8));
+            auto delta = encoder.encode(data, data.size() > 0 ? data.size() - 1 : 0);
+            if (delta) {
+                planned.delta = std::move(*delta);
+            }
+            else {
+                planned.op = PatchOp::Literal;
+                planned.base = nullptr;
+            }
+        });
+
+        PatchStats stats;
+        std::vector<std::byte> header;
+        header.insert(header.end(), std::as_bytes(std::span(kPatchMagic)).begin(),
+            std::as_bytes(std::span(kPatchMagic)).end());
+        put_string(header, new_archive.identifier());
+        put_string(header, new_archive.version());
+        header.push_back(static_cast<std::byte>(new_archive.endianness()));
+        put_varint(header, plan.size());
+
+        for (const auto& planned : plan) {
+            put_string(header, planned.file->path());
+            put_varint(header, planned.file->size());
+            put_varint(header, planned.file->align());
+            for (int shift = 0; shift < 32; shift += 8) {
+                header.push_back(static_cast<std::byte>(planned.crc32c >> shift));
+            }
+            header.push_back(static_cast<std::byte>(planned.op));
+            if (planned.base) {
+                put_string(header, planned.base->path());
+                put_varint(header, planned.base->size());
+            }
+
+            switch (planned.op) {
+            case PatchOp::Copy:
+                ++stats.copied;
+                break;
+            case PatchOp::Literal:
+                put_varint(header, planned.file->size());
+                ++stats.literal;
+                break;
+            case PatchOp::Delta:
+                put_varint(header, planned.delta.size());
+                ++stats.delta;
+                break;
+            }
+        }
+
+        write_bytes(patch, header);
+        stats.patch_size = header.size();
+        for (const auto& planned : plan) {
+            std::span<const std::byte> body;
+            if (planned.op == PatchOp::Literal) {
+                body = planned.file->raw_data();
+            }
+            else if (planned.op == PatchOp::Delta) {
+                body = planned.delta;
+            }
+            write_bytes(patch, body);
+            stats.patch_size += body.size();
+        }
+
+        for (const auto& file : new_archive.files()) {
+            stats.new_archive_size = std::max(stats.new_archive_size, file->offset() + file->size());
+        }
+        return stats;
+    }
+
+    PatchStats create_patch(const ArchiveReader& old_archive, const ArchiveReader& new_archive,
+        const std::string& patch_path, const PatchOptions& options) {
+        std::ofstream file(patch_path, std::ios::binary);
+        if (!file) {
+            throw IOError("Failed to open file for writing: " + patch_path);
+        }
+        return create_patch(old_archive, new_archive, file, options);
+    }
+
+    void apply_patch(const ArchiveReader& old_archive, std::istream& patch, std::ostream& out) {
+        PatchInput input(patch);
+
+        std::array<char, kPatchMagic.size()> magic{};
+        input.read(magic.data(), magic.size());
+        if (magic != kPatchMagic) {
+            throw ArchiveFormatException("Not an RPFL patch");
+        }
+
+        ArchiveWriter writer;
+        writer.set_identifier(input.string());
+        writer.set_version(input.string());
+        std::uint8_t endianness = input.byte();
+        if (endianness > static_cast<std::uint8_t>(Endianness::Native)) {
+            throw ArchiveFormatException("Invalid endianness in patch");
+        }
+        writer.set_endianness(static_cast<Endianness>(endianness));
+
+        std::uint64_t count = input.varint();
+        std::vector<PatchEntry> entries;
+        entries.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(count, kMaxBlocks)));
+        for (std::uint64_t i = 0; i < count; ++i) {
+            PatchEntry entry;
+            entry.path = input.string();
+            entry.size = input.varint();
+            entry.align = static_cast<std::uint32_t>(input.varint());
+            for (int shift = 0; shift < 32; shift += 8) {
+                entry.crc32c |= static_cast<std::uint32_t>(input.byte()) << shift;
+            }
+            std::uint8_t op = input.byte();
+            if (op > static_cast<std::uint8_t>(PatchOp::Delta)) {
+                throw ArchiveFormatException(std::format("Unknown operation for '{}' in patch", entry.path));
+            }
+            entry.op = static_cast<PatchOp>(op);
+
+            if (entry.op != PatchOp::Literal) {
+                std::string base_path = input.string();
+                std::uint64_t base_size = input.varint();
+                entry.base = old_archive.find(base_path);
+                if (!entry.base || entry.base->size() != base_size) {
+                    throw ArchiveFormatException(std::format(
+                        "Patch does not apply: old archive has no '{}' of {} bytes", base_path, base_size));
+                }
+                if (entry.op == PatchOp::Copy && base_size != entry.size) {
+                    throw ArchiveFormatException(std::format("Copy of '{}' changes its size", entry.path));
+                }
+            }
+            if (entry.op != PatchOp::Copy) {
+                entry.body_size = input.varint();
+                if (entry.op == PatchOp::Literal && entry.body_size != entry.size) {
+                    throw ArchiveFormatException(std::format("Literal '{}' has the wrong size", entry.path));
+                }
+            }
+            entries.push_back(std::move(entry));
+        }
+
+        // Sources run in entry order, which is the order of the bodies in the patch
+        for (const auto& entry : entries) {
+            writer.add_file_source(entry.path, entry.size, [&input, &entry](const ArchiveWriter::ChunkSink& sink) {
+                Crc32c crc;
+                auto checked = [&](std::span<const std::byte> chunk) {
+                    crc.update(chunk);
+                    sink(chunk);
+                };
+
+                switch (entry.op) {
+                case PatchOp::Copy:
+                    checked(entry.base->raw_data());
+                    break;
+                case PatchOp::Literal:
+                    input.stream(entry.body_size, checked);
+                    break;
+                case PatchOp::Delta:
+                    apply_delta(input, entry.body_size, entry.base->raw_data(), checked);
+                    break;
+                }
+
+                if (crc.value() != entry.crc32c) {
+                    throw ArchiveFormatException(std::format("Patched '{}' fails its CRC-32C check", entry.path));
+                }
+            }, entry.align);
+        }
+
+        writer.write(out);
+        if (!input.at_end()) {
+            throw ArchiveFormatException("Trailing data after the last patch entry");
+        }
+    }
+
+    void apply_patch(const ArchiveReader& old_archive, const std::string& patch_path,
+        const std::string& out_path) {
+        std::ifstream patch(patch_path, std::ios::binary);
+        if (!patch) {
+            throw IOError("Failed to open patch: " + patch_path);
+        }
+        std::ofstream out(out_path, std::ios::binary);
+        if (!out) {
+            throw IOError("Failed to open file for writing: " + out_path);
+        }
+        apply_patch(old_archive, patch, out);
+    }
+
+} // namespace RPFL
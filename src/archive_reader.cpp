@@ -7,9 +7,31 @@
 #include <type_traits>
 
 #include "archive_reader.hpp"
+#include "path_utils.hpp"
 
 namespace RPFL {
 
+    namespace {
+
+        // Orders an index key against a query, folding the query the way the
+        // keys of a normalized index were folded
+        int compare_query(std::string_view key, std::string_view query, bool fold) noexcept {
+            if (!fold) {
+                return key.compare(query);
+            }
+            std::size_t size = std::min(key.size(), query.size());
+            for (std::size_t i = 0; i < size; ++i) {
+                auto a = static_cast<unsigned char>(key[i]);
+                auto b = static_cast<unsigned char>(fold_path_char(query[i]));
+                if (a != b) {
+                    return a < b ? -1 : 1;
+                }
+            }
+            return key.size() < query.size() ? -1 : key.size() > query.size() ? 1 : 0;
+        }
+
+    } // namespace
+
     ArchiveReader::ArchiveReader(
         const std::string& filepath,
         std::size_t cache_threshold,
@@ -43,13 +65,23 @@ namespace RPFL {
         allow_streaming_ = allow_streaming;
         mmap_options_ = std::move(mmap_options);
         file_endianness_ = file_endianness;
+        // The index is built for the mode set now, later set_* calls wait for a reopen
+        compact_index_ = compact_paths_;
+        normalized_index_ = normalized_lookup_;
 
         try {
-            mmap_file_.open(filepath, mmap_options_);
-            auto data = mmap_file_.data();
+            detail::LatencyScope latency(LatencyOp::Open);
+            // A new mapping each time, streams of the previous one keep it
+            mmap_file_ = std::make_shared<MemoryMappedFile>(filepath, mmap_options_);
+            auto data = mmap_file_->data();
 
             parse_header(data);
             parse_file_table(data, header_.data_offset);
+            build_sorted_index();
+            if (build_path_filter_) {
+                build_filter();
+            }
+            attach_trace();
 
             is_open_ = true;
         }
@@ -61,8 +93,17 @@ namespace RPFL {
 
     void ArchiveReader::close() {
         files_.clear();
+        path_storage_.clear();
         file_map_.clear();
-        mmap_file_.close();
+        sorted_files_.clear();
+        sorted_keys_.clear();
+        compact_table_.clear();
+        normalized_map_.clear();
+        normalized_storage_.clear();
+        path_filter_.clear();
+        compact_index_ = false;
+        normalized_index_ = false;
+        mmap_file_.reset();
         is_open_ = false;
     }
 
@@ -129,6 +170,11 @@ namespace RPFL {
 
         std::uint64_t current_offset = data_offset;
 
+        // Paths can't take more than the table itself, so views never move
+        if (!compact_index_) {
+            path_storage_.reserve(std::min<std::size_t>(data_offset, data.size()));
+        }
+
         for (std::uint64_t i = 0; i < num_files; ++i) {
             // file_path_length
             if (static_cast<std::size_t>(ptr - data.data()) + 8 > data.size()) {
@@ -142,9 +188,18 @@ namespace RPFL {
                 throw ArchiveFormatException("File path extends beyond file");
             }
 
-            std::string file_path(reinterpret_cast<const char*>(ptr), path_length);
+            std::string_view file_path(reinterpret_cast<const char*>(ptr), path_length);
             ptr += path_length;
 
+            if (!compact_index_) {
+                if (path_storage_.size() + path_length > path_storage_.capacity()) {
+                    throw ArchiveFormatException("File table extends beyond data offset");
+                }
+                std::size_t stored_at = path_storage_.size();
+                path_storage_.insert(path_storage_.end(), file_path.begin(), file_path.end());
+                file_path = { path_storage_.data() + stored_at, file_path.size() };
+            }
+
             // file_length
             if (static_cast<std::size_t>(ptr - data.data()) + 8 > data.size()) {
                 throw ArchiveFormatException("Incomplete file length");
@@ -158,9 +213,7 @@ namespace RPFL {
             ptr += sizeof(file_align);
 
             // 
-            if (file_align > 1) {
-                current_offset = (current_offset + file_align - 1) & ~(file_align - 1);
-            }
+            current_offset = align_up(current_offset, file_align);
 
             // ,        
             if (current_offset + file_size > data.size()) {
@@ -171,15 +224,128 @@ namespace RPFL {
             auto archive_file = std::make_unique<ArchiveFile>(
                 file_path, current_offset, file_size,
                 data.data(), cache_threshold_,
-                allow_streaming_);
+                allow_streaming_, std::max<std::uint32_t>(file_align, 1), mmap_file_);
 
-            file_map_[archive_file->path()] = archive_file.get();
+            if (!compact_index_ && !normalized_index_) {
+                file_map_[archive_file->path()] = archive_file.get();
+            }
             files_.push_back(std::move(archive_file));
 
             current_offset += file_size;
         }
     }
 
+    void ArchiveReader::build_sorted_index() {
+        if (normalized_index_) {
+            build_normalized_index();
+            return;
+        }
+
+        sorted_files_.reserve(files_.size());
+        for (const auto& file : files_) {
+            sorted_files_.push_back(file.get());
+        }
+        // Stable, so duplicate paths stay in table order and the last one wins
+        std::ranges::stable_sort(sorted_files_, {}, &ArchiveFile::path);
+
+        if (compact_index_) {
+            std::vector<std::string_view> paths;
+            paths.reserve(sorted_files_.size());
+            for (const ArchiveFile* file : sorted_files_) {
+                paths.push_back(file->path());
+            }
+            compact_table_.build(paths);
+        }
+    }
+
+    void ArchiveReader::build_normalized_index() {
+        std::size_t total = 0;
+        for (const auto& file : files_) {
+            total += file->path().size();
+        }
+
+        normalized_storage_.resize(total);
+        normalized_map_.reserve(files_.size());
+
+        using Keyed = std::pair<std::string_view, ArchiveFile*>;
+        std::vector<Keyed> sorted;
+        sorted.reserve(files_.size());
+
+        char* out = normalized_storage_.data();
+        for (const auto& file : files_) {
+            std::string_view path = file->path();
+            normalize_path(path.data(), out, path.size());
+            std::string_view key(out, path.size());
+            // Paths equal after folding case and slashes: the last one wins,
+            // as in the hash index
+            normalized_map_.insert_or_assign(key, file.get());
+            sorted.emplace_back(key, file.get());
+            out += path.size();
+        }
+
+        // Sorted by the folded paths, so list_dir() and glob() fold like find()
+        std::ranges::stable_sort(sorted, {}, &Keyed::first);
+        sorted_files_.reserve(sorted.size());
+        sorted_keys_.reserve(sorted.size());
+        for (const auto& [key, file] : sorted) {
+            sorted_keys_.push_back(key);
+            sorted_files_.push_back(file);
+        }
+    }
+
+    void ArchiveReader::build_filter() {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(files_.size());
+        for (const auto& file : files_) {
+            hashes.push_back(normalized_index_
+                ? PathFilter::normalized_hash(file->path())
+                : PathFilter::hash(file->path()));
+        }
+        path_filter_.build(hashes);
+    }
+
+    ArchiveFile* ArchiveReader::lookup(std::string_view path) const noexcept {
+        detail::LatencyScope latency(LatencyOp::Lookup);
+        ArchiveFile* file = lookup_index(path);
+        detail::count(file ? detail::LookupHits : detail::LookupMisses);
+        return file;
+    }
+
+    ArchiveFile* ArchiveReader::lookup_index(std::string_view path) const noexcept {
+        if (normalized_index_) {
+            auto it = normalized_map_.find(UnnormalizedPath{ path });
+            return it == normalized_map_.end() ? nullptr : it->second;
+        }
+        if (compact_index_) {
+            std::size_t index = compact_table_.find(path);
+            if (index == CompactPathTable::npos) {
+                return nullptr;
+            }
+            // Any of a run of duplicates may match, step to the last one
+            while (index + 1 < sorted_files_.size() && sorted_files_[index + 1]->path() == path) {
+                ++index;
+            }
+            return sorted_files_[index];
+        }
+        auto it = file_map_.find(path);
+        return it == file_map_.end() ? nullptr : it->second;
+    }
+
+    std::size_t ArchiveReader::index_memory_usage() const noexcept {
+        std::size_t total = sorted_files_.capacity() * sizeof(ArchiveFile*)
+            + sorted_keys_.capacity() * sizeof(std::string_view)
+            + path_storage_.capacity()
+            + compact_table_.memory_usage()
+            + normalized_storage_.capacity()
+            + path_filter_.memory_usage();
+        // Rough figure for the node based map: node + bucket per element
+        for (std::size_t size : { file_map_.size(), normalized_map_.size() }) {
+            total += size * (sizeof(std::pair<std::string_view, ArchiveFile*>) + 2 * sizeof(void*));
+        }
+        total += (file_map_.bucket_count() + normalized_map_.bucket_count()) * sizeof(void*);
+        return total;
+    }
+
     std::string_view ArchiveReader::identifier() const noexcept {
         return header_.identifier;
     }
@@ -192,24 +358,125 @@ namespace RPFL {
         return files_.size();
     }
 
-    ArchiveFile& ArchiveReader::get_file(const std::string& path) {
-        auto it = file_map_.find(path);
-        if (it == file_map_.end()) {
-            throw FileNotFoundException(path);
+    void ArchiveReader::start_trace(const std::string& filepath) {
+        trace_ = std::make_unique<AccessTraceRecorder>(filepath);
+        attach_trace();
+    }
+
+    void ArchiveReader::stop_trace() {
+        if (!trace_) {
+            return;
         }
-        return *it->second;
+        auto trace = std::move(trace_);
+        attach_trace();
+        trace->flush();
     }
 
-    const ArchiveFile& ArchiveReader::get_file(const std::string& path) const {
-        auto it = file_map_.find(path);
-        if (it == file_map_.end()) {
-            throw FileNotFoundException(path);
+    void ArchiveReader::attach_trace() noexcept {
+        for (auto& file : files_) {
+            file->trace_ = trace_.get();
+        }
+    }
+
+    ArchiveFile& ArchiveReader::get_file(std::string_view path) {
+        if (trace_) {
+            trace_->record(TraceOp::Lookup, path, 0, 0);
+        }
+        ArchiveFile* file = lookup(path);
+        if (!file) {
+            throw FileNotFoundException(std::string(path));
+        }
+        return *file;
+    }
+
+    const ArchiveFile& ArchiveReader::get_file(std::string_view path) const {
+        if (trace_) {
+            trace_->record(TraceOp::Lookup, path, 0, 0);
+        }
+        const ArchiveFile* file = lookup(path);
+        if (!file) {
+            throw FileNotFoundException(std::string(path));
+        }
+        return *file;
+    }
+
+    bool ArchiveReader::contains(std::string_view path) const noexcept {
+        if (trace_) {
+            trace_->record(TraceOp::Lookup, path, 0, 0);
         }
-        return *it->second;
+        return lookup(path) != nullptr;
+    }
+
+    ArchiveFile* ArchiveReader::find(std::string_view path) const noexcept {
+        if (trace_) {
+            trace_->record(TraceOp::Lookup, path, 0, 0);
+        }
+        return lookup(path);
+    }
+
+    std::span<ArchiveFile* const> ArchiveReader::list_dir(std::string_view dir) const noexcept {
+        bool fold = normalized_index_;
+        bool trailing_slash = !dir.empty() && (fold ? fold_path_char(dir.back()) : dir.back()) == '/';
+        // Sorts before every "dir/..." entry; "dir" itself and "dir-x" count as before
+        auto before = [&](std::size_t index) {
+            std::string_view path = sorted_key(index);
+            int cmp = compare_query(path.substr(0, dir.size()), dir, fold);
+            if (cmp != 0) {
+                return cmp < 0;
+            }
+            return !dir.empty() && !trailing_slash &&
+                (path.size() == dir.size() ||
+                    static_cast<unsigned char>(path[dir.size()]) < '/');
+        };
+        auto under = [&](std::size_t index) {
+            std::string_view path = sorted_key(index);
+            return compare_query(path.substr(0, dir.size()), dir, fold) == 0 &&
+                (dir.empty() || trailing_slash || (path.size() > dir.size() && path[dir.size()] == '/'));
+        };
+
+        auto indices = std::views::iota(std::size_t{ 0 }, sorted_files_.size());
+        auto first = std::ranges::partition_point(indices, before);
+        auto last = std::ranges::partition_point(first, indices.end(), under);
+        return std::span<ArchiveFile* const>(sorted_files_).subspan(*first, *last - *first);
     }
 
-    bool ArchiveReader::contains(const std::string& path) const noexcept {
-        return file_map_.find(path) != file_map_.end();
+    std::span<ArchiveFile* const> ArchiveReader::list_range(std::string_view first,
+        std::string_view last) const noexcept {
+        auto lower_bound = [this](std::string_view bound) {
+            auto indices = std::views::iota(std::size_t{ 0 }, sorted_files_.size());
+            return *std::ranges::partition_point(indices, [&](std::size_t index) {
+                return compare_query(sorted_key(index), bound, normalized_index_) < 0;
+            });
+        };
+        std::size_t begin = lower_bound(first);
+        std::size_t end = std::max(begin, lower_bound(last));
+        return std::span<ArchiveFile* const>(sorted_files_).subspan(begin, end - begin);
+    }
+
+    std::vector<ArchiveFile*> ArchiveReader::glob(std::string_view pattern) const {
+        // Wildcards are left alone by the folding, the keys are already folded
+        std::string folded;
+        if (normalized_index_) {
+            folded.resize(pattern.size());
+            normalize_path(pattern.data(), folded.data(), pattern.size());
+            pattern = folded;
+        }
+
+        // Only the entries sharing the literal prefix can match
+        std::string_view prefix = glob_literal_prefix(pattern);
+        auto indices = std::views::iota(std::size_t{ 0 }, sorted_files_.size());
+        auto first = std::ranges::partition_point(indices,
+            [&](std::size_t index) { return sorted_key(index) < prefix; });
+        auto last = std::ranges::partition_point(first, indices.end(),
+            [&](std::size_t index) { return sorted_key(index).starts_with(prefix); });
+
+        std::vector<ArchiveFile*> matches;
+        for (auto it = first; it != last; ++it) {
+            if (glob_match(pattern, sorted_key(*it))) {
+                matches.push_back(sorted_files_[*it]);
+            }
+        }
+        return matches;
     }
 
     const std::vector<std::unique_ptr<ArchiveFile>>& ArchiveReader::files() const noexcept {
@@ -232,14 +499,16 @@ namespace RPFL {
         return total;
     }
 
-    std::span<const std::byte> ArchiveReader::read_raw(const std::string& path) const {
-        auto it = file_map_.find(path);
-        if (it == file_map_.end()) {
-            throw FileNotFoundException(path);
+    std::span<const std::byte> ArchiveReader::read_raw(std::string_view path) const {
+        const ArchiveFile* file = lookup(path);
+        if (!file) {
+            throw FileNotFoundException(std::string(path));
+        }
+        if (trace_) {
+            trace_->record(TraceOp::ReadRaw, path, 0, file->size());
         }
 
-        const ArchiveFile* file = it->second;
-        const std::byte* data = mmap_file_.data().data() + file->offset();
+        const std::byte* data = mmap_file_->data().data() + file->offset();
         return { data, file->size() };
     }
 
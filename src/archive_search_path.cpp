@@ -0,0 +1,62 @@
+#include "archive_search_path.hpp"
+#include "path_filter.hpp"
+
+namespace RPFL {
+
+    void ArchiveSearchPath::add(std::shared_ptr<ArchiveReader> reader) {
+        if (!reader || !reader->is_open()) {
+            throw ArchiveException("Cannot add an archive that is not open");
+        }
+        readers_.push_back(std::move(reader));
+    }
+
+    ArchiveSearchPath::Result ArchiveSearchPath::find(std::string_view path) const noexcept {
+        // Each flavour of the hash is computed at most once per lookup
+        std::uint64_t hash = 0;
+        std::uint64_t normalized_hash = 0;
+        bool has_hash = false;
+        bool has_normalized_hash = false;
+
+        for (const auto& reader : readers_) {
+            const PathFilter& filter = reader->path_filter();
+            if (!filter.empty()) {
+                std::uint64_t h;
+                if (reader->normalized_index()) {
+                    if (!has_normalized_hash) {
+                        normalized_hash = PathFilter::normalized_hash(path);
+                        has_normalized_hash = true;
+                    }
+                    h = normalized_hash;
+                }
+                else {
+                    if (!has_hash) {
+                        hash = PathFilter::hash(path);
+                        has_hash = true;
+                    }
+                    h = hash;
+                }
+                if (!filter.might_contain(h)) {
+                    continue;
+                }
+            }
+
+            if (ArchiveFile* file = reader->find(path)) {
+                return { file, reader.get() };
+            }
+        }
+        return {};
+    }
+
+    ArchiveFile& ArchiveSearchPath::get_file(std::string_view path) const {
+        Result result = find(path);
+        if (!result) {
+            throw FileNotFoundException(std::string(path));
+        }
+        return *result.file;
+    }
+
+    std::span<const std::byte> ArchiveSearchPath::read_raw(std::string_view path) const {
+        return get_file(path).raw_data();
+    }
+
+} // namespace RPFL
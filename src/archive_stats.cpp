@@ -0,0 +1,113 @@
+#include "archive_stats.hpp"
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace RPFL {
+
+#ifdef RPFL_ENABLE_STATS
+
+    namespace {
+
+        using Totals = std::array<std::uint64_t, detail::CounterCount>;
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<detail::CounterBlock*> live;
+            Totals retired{}; // from threads that have exited
+            Totals base{};    // totals at the last reset
+        };
+
+        // Never destroyed: thread_local blocks may retire after static
+        // destructors have run
+        Registry& registry() {
+            static Registry* instance = new Registry;
+            return *instance;
+        }
+
+        Totals totals_locked(const Registry& reg) {
+            Totals totals = reg.retired;
+            for (const auto* block : reg.live) {
+                for (std::size_t i = 0; i < detail::CounterCount; ++i) {
+                    totals[i] += block->values[i].load(std::memory_order_relaxed);
+                }
+            }
+            return totals;
+        }
+
+    } // namespace
+
+    namespace detail {
+
+        CounterBlock::CounterBlock() noexcept {
+            try {
+                Registry& reg = registry();
+                std::lock_guard lock(reg.mutex);
+                reg.live.push_back(this);
+                registered = true;
+            }
+            catch (const std::exception&) {
+            }
+        }
+
+        CounterBlock::~CounterBlock() {
+            if (!registered) {
+                return;
+            }
+            Registry& reg = registry();
+            std::lock_guard lock(reg.mutex);
+            for (std::size_t i = 0; i < CounterCount; ++i) {
+                reg.retired[i] += values[i].load(std::memory_order_relaxed);
+            }
+            reg.live.erase(std::find(reg.live.begin(), reg.live.end(), this));
+        }
+
+    } // namespace detail
+
+    ArchiveStats stats() {
+        Registry& reg = registry();
+        Totals totals;
+        Totals base;
+        {
+            std::lock_guard lock(reg.mutex);
+            totals = totals_locked(reg);
+            base = reg.base;
+        }
+        auto since_reset = [&](detail::Counter counter) { return totals[counter] - base[counter]; };
+
+        ArchiveStats result;
+        result.lookup_hits = since_reset(detail::LookupHits);
+        result.lookup_misses = since_reset(detail::LookupMisses);
+        result.lookups = result.lookup_hits + result.lookup_misses;
+        result.loads = since_reset(detail::Loads);
+        result.cache_fills = since_reset(detail::CacheFills);
+        result.bytes_copied = since_reset(detail::BytesCopied);
+        // A level, not a count, so always from the absolute totals
+        result.bytes_cached = totals[detail::BytesCacheFilled] - std::min(totals[detail::BytesEvicted],
+            totals[detail::BytesCacheFilled]);
+        result.cache_evictions = since_reset(detail::CacheEvictions);
+        result.maps = since_reset(detail::Maps);
+        result.bytes_mapped = since_reset(detail::BytesMapped);
+        result.stream_opens = since_reset(detail::StreamOpens);
+        return result;
+    }
+
+    void reset_stats() {
+        Registry& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.base = totals_locked(reg);
+    }
+
+#else
+
+    ArchiveStats stats() {
+        return {};
+    }
+
+    void reset_stats() {}
+
+#endif
+
+} // namespace RPFL
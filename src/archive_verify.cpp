@@ -0,0 +1,68 @@
+#include "archive_reader.hpp"
+#include "archive_hash.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace RPFL {
+
+    VerifyReport ArchiveReader::verify(const VerifyOptions& options) const {
+        VerifyReport report;
+        report.entries.reserve(files_.size());
+        for (const auto& file : files_) {
+            report.entries.push_back({ file.get(), 0 });
+        }
+        // Table order already is offset order for well-formed archives
+        std::ranges::stable_sort(report.entries, {},
+            [](const VerifyReport::Entry& entry) { return entry.file->offset(); });
+
+        parallel_for(report.entries.size(), options.threads, [&report](std::size_t i) {
+            auto& entry = report.entries[i];
+            entry.crc32c = crc32c(entry.file->raw_data());
+        });
+
+        if (!options.manifest) {
+            return report;
+        }
+
+        std::unordered_set<std::string_view> seen;
+        for (const auto& entry : report.entries) {
+            std::string_view path = entry.file->path();
+            seen.insert(path);
+            const ArchiveManifest::Entry* expected = options.manifest->find(path);
+            if (!expected) {
+                if (path != ArchiveManifest::kEmbeddedPath) {
+                    report.unexpected.emplace_back(path);
+                }
+            }
+            else if (expected->size != entry.file->size() || expected->crc32c != entry.crc32c) {
+                report.mismatched.emplace_back(path);
+            }
+        }
+        for (const auto& expected : options.manifest->entries()) {
+            if (!seen.contains(expected.path)) {
+                report.missing.push_back(expected.path);
+            }
+        }
+        return report;
+    }
+
+    std::optional<ArchiveManifest> ArchiveReader::embedded_manifest() const {
+        const ArchiveFile* file = lookup(ArchiveManifest::kEmbeddedPath);
+        if (!file) {
+            return std::nullopt;
+        }
+        auto data = file->raw_data();
+        return ArchiveManifest::parse({ reinterpret_cast<const char*>(data.data()), data.size() });
+    }
+
+    ArchiveManifest VerifyReport::to_manifest() const {
+        ArchiveManifest manifest;
+        for (const auto& entry : entries) {
+            manifest.add({ std::string(entry.file->path()), entry.file->offset(),
+                entry.file->size(), entry.file->align(), entry.crc32c });
+        }
+        return manifest;
+    }
+
+} // namespace RPFL
@@ -1,7 +1,18 @@
 #include "archive_writer.hpp"
+#include "archive_hash.hpp"
+#include "direct_output.hpp"
 #include <fstream>
 #include <format>
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace RPFL {
 
@@ -18,20 +29,38 @@ namespace RPFL {
 
     void ArchiveWriter::add_file(const std::string& path, std::span<const std::byte> data,
         std::uint32_t alignment) {
-        if (path.empty()) {
-            throw ArchiveException("File path cannot be empty");
-        }
+        FileEntry entry;
+        entry.path = path;
+        entry.data.assign(data.begin(), data.end());
+        entry.size = entry.data.size();
+        add_entry(std::move(entry), alignment);
+    }
 
-        if (contains(path)) {
-            throw ArchiveException(std::format("File '{}' already exists in archive", path));
+    void ArchiveWriter::add_file_source(const std::string& path, std::uint64_t size,
+        EntrySource source, std::uint32_t alignment) {
+        if (!source) {
+            throw ArchiveException(std::format("File '{}' has no data source", path));
         }
 
         FileEntry entry;
         entry.path = path;
-        entry.data.assign(data.begin(), data.end());
-        entry.align = alignment > 0 ? alignment : default_alignment_;
+        entry.size = size;
+        entry.source = std::move(source);
+        add_entry(std::move(entry), alignment);
+    }
 
-        files_[path] = std::move(entry);
+    void ArchiveWriter::add_entry(FileEntry entry, std::uint32_t alignment) {
+        if (entry.path.empty()) {
+            throw ArchiveException("File path cannot be empty");
+        }
+
+        if (contains(entry.path)) {
+            throw ArchiveException(std::format("File '{}' already exists in archive", entry.path));
+        }
+
+        entry.align = alignment > 0 ? alignment : default_alignment_;
+        file_index_.emplace(entry.path, files_.size());
+        files_.push_back(std::move(entry));
     }
 
     void ArchiveWriter::add_file(const std::string& path, const std::string& data,
@@ -64,27 +93,82 @@ namespace RPFL {
         return true;
     }
 
+    bool ArchiveWriter::add_file_streamed(const std::filesystem::path& filepath,
+        const std::string& archive_path,
+        std::uint32_t alignment) {
+        std::error_code error;
+        std::uint64_t size = std::filesystem::file_size(filepath, error);
+        if (error) {
+            return false;
+        }
+
+        std::string path = archive_path.empty() ? filepath.filename().string() : archive_path;
+        std::size_t chunk_size = stream_chunk_size_;
+        add_file_source(path, size, [filepath, chunk_size, size](const ChunkSink& sink) {
+            std::ifstream file(filepath, std::ios::binary);
+            if (!file) {
+                throw IOError("Failed to open file for reading: " + filepath.string());
+            }
+
+            // Read to the end, the size check in write() catches a file that changed
+            std::vector<std::byte> buffer(static_cast<std::size_t>(
+                std::min<std::uint64_t>(chunk_size, size + 1)));
+            while (file) {
+                file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                sink(std::span<const std::byte>(buffer.data(), static_cast<std::size_t>(file.gcount())));
+            }
+            if (file.bad()) {
+                throw IOError("Failed to read file: " + filepath.string());
+            }
+        }, alignment);
+        return true;
+    }
+
     bool ArchiveWriter::remove_file(const std::string& path) {
-        return files_.erase(path) > 0;
+        auto it = file_index_.find(path);
+        if (it == file_index_.end()) {
+            return false;
+        }
+
+        std::size_t index = it->second;
+        file_index_.erase(it);
+        files_.erase(files_.begin() + index);
+        for (std::size_t i = index; i < files_.size(); ++i) {
+            file_index_[files_[i].path] = i;
+        }
+        return true;
     }
 
     void ArchiveWriter::clear() {
         files_.clear();
+        file_index_.clear();
     }
 
     std::size_t ArchiveWriter::total_size() const noexcept {
         std::size_t total = calculate_header_size();
-        for (const auto& [path, entry] : files_) {
-            if (entry.align > 1) {
-                total = (total + entry.align - 1) & ~(entry.align - 1);
-            }
-            total += entry.data.size();
+        for (const auto& entry : files_) {
+            total = align_up(total, entry.align);
+            total += entry.size;
+        }
+        if (embeds_manifest()) {
+            total += manifest_size();
         }
         return total;
     }
 
+    std::uint64_t ArchiveWriter::manifest_size() const {
+        std::uint64_t size = ArchiveManifest::kHeader.size() + 1;
+        std::uint64_t offset = calculate_header_size();
+        for (const auto& entry : files_) {
+            offset = align_up(offset, entry.align);
+            size += ArchiveManifest::line_size(entry.path.size(), offset, entry.size, entry.align);
+            offset += entry.size;
+        }
+        return size;
+    }
+
     bool ArchiveWriter::contains(const std::string& path) const noexcept {
-        return files_.find(path) != files_.end();
+        return file_index_.find(path) != file_index_.end();
     }
 
     std::uint64_t ArchiveWriter::calculate_header_size() const {
@@ -103,13 +187,18 @@ namespace RPFL {
         size += sizeof(std::uint64_t);
 
         // file table entries
-        for (const auto& [path, entry] : files_) {
+        for (const auto& entry : files_) {
             size += sizeof(std::uint64_t); // path length
-            size += path.size();
+            size += entry.path.size();
             size += sizeof(std::uint64_t); // file size
             size += sizeof(std::uint32_t); // alignment
         }
 
+        if (embeds_manifest()) {
+            size += sizeof(std::uint64_t) + ArchiveManifest::kEmbeddedPath.size()
+                + sizeof(std::uint64_t) + sizeof(std::uint32_t);
+        }
+
         return size;
     }
 
@@ -135,22 +224,22 @@ namespace RPFL {
         offset += version_length;
 
         // Write number of files
-        std::uint64_t num_files = files_.size();
+        std::uint64_t num_files = files_.size() + (embeds_manifest() ? 1 : 0);
         write_with_endianness(buffer + offset, num_files, endianness_);
         offset += sizeof(num_files);
     }
 
     void ArchiveWriter::write_file_table(std::byte* buffer, std::uint64_t& offset) const {
-        for (const auto& [path, entry] : files_) {
+        for (const auto& entry : files_) {
             // Write path length and path
-            std::uint64_t path_length = path.size();
+            std::uint64_t path_length = entry.path.size();
             write_with_endianness(buffer + offset, path_length, endianness_);
             offset += sizeof(path_length);
-            std::memcpy(buffer + offset, path.data(), path_length);
+            std::memcpy(buffer + offset, entry.path.data(), path_length);
             offset += path_length;
 
             // Write file size
-            std::uint64_t file_size = entry.data.size();
+            std::uint64_t file_size = entry.size;
             write_with_endianness(buffer + offset, file_size, endianness_);
             offset += sizeof(file_size);
 
@@ -158,74 +247,177 @@ namespace RPFL {
             write_with_endianness(buffer + offset, entry.align, endianness_);
             offset += sizeof(entry.align);
         }
-    }
-
-    void ArchiveWriter::write_file_data(std::byte* buffer, std::uint64_t& offset) const {
-        for (const auto& [path, entry] : files_) {
-            // Apply alignment
-            if (entry.align > 1) {
-                offset = (offset + entry.align - 1) & ~(entry.align - 1);
-            }
 
-            // Write file data
-            std::memcpy(buffer + offset, entry.data.data(), entry.data.size());
-            offset += entry.data.size();
+        if (embeds_manifest()) {
+            std::string_view path = ArchiveManifest::kEmbeddedPath;
+            write_with_endianness(buffer + offset, static_cast<std::uint64_t>(path.size()), endianness_);
+            offset += sizeof(std::uint64_t);
+            std::memcpy(buffer + offset, path.data(), path.size());
+            offset += path.size();
+
+            write_with_endianness(buffer + offset, manifest_size(), endianness_);
+            offset += sizeof(std::uint64_t);
+            write_with_endianness(buffer + offset, std::uint32_t{ 1 }, endianness_);
+            offset += sizeof(std::uint32_t);
         }
     }
 
     void ArchiveWriter::write(const std::string& filepath) {
-        std::ofstream file(filepath, std::ios::binary);
-        if (!file) {
-            throw IOError("Failed to open file for writing: " + filepath);
+        if (output_mode_ != OutputMode::Buffered) {
+            DirectOutput output(filepath, output_mode_);
+            write([&output](std::span<const std::byte> chunk) { output.write(chunk); });
+            output.finish();
+        }
+        else {
+            std::ofstream file(filepath, std::ios::binary);
+            if (!file) {
+                throw IOError("Failed to open file for writing: " + filepath);
+            }
+            write(file);
+        }
+
+        if (manifest_mode_ == ManifestMode::Sidecar) {
+            manifest_.save(filepath + ".manifest");
         }
-        write(file);
     }
 
     void ArchiveWriter::write(std::ostream& stream) {
-        std::vector<std::byte> data = write_to_memory();
-        stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+        write([&stream](std::span<const std::byte> chunk) {
+            stream.write(reinterpret_cast<const char*>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size()));
+            if (!stream) {
+                throw IOError("Failed to write archive data");
+            }
+        });
     }
 
-    std::vector<std::byte> ArchiveWriter::write_to_memory() {
-        std::size_t total = total_size();
-        std::vector<std::byte> buffer(total);
+    void ArchiveWriter::write(int fd) {
+        auto write_all = [fd](const std::byte* data, std::size_t size) {
+            while (size > 0) {
+#ifdef _WIN32
+                int count = ::_write(fd, data, static_cast<unsigned>(std::min<std::size_t>(size, 1u << 30)));
+#else
+                ssize_t count = ::write(fd, data, size);
+#endif
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw IOError(std::format("Failed to write archive data: {}", std::strerror(errno)));
+                }
+                data += count;
+                size -= static_cast<std::size_t>(count);
+            }
+        };
+
+        // Padding, headers and small entries are gathered, big chunks go straight through
+        std::vector<std::byte> pending;
+        pending.reserve(stream_chunk_size_);
+        write([&](std::span<const std::byte> chunk) {
+            if (pending.size() + chunk.size() > pending.capacity()) {
+                write_all(pending.data(), pending.size());
+                pending.clear();
+            }
+            if (chunk.size() >= pending.capacity()) {
+                write_all(chunk.data(), chunk.size());
+            }
+            else {
+                pending.insert(pending.end(), chunk.begin(), chunk.end());
+            }
+        });
+        write_all(pending.data(), pending.size());
+    }
 
+    void ArchiveWriter::write(const ChunkSink& sink) {
+        if (embeds_manifest() && contains(std::string(ArchiveManifest::kEmbeddedPath))) {
+            throw ArchiveException(std::format("'{}' is reserved for the embedded manifest",
+                ArchiveManifest::kEmbeddedPath));
+        }
+
+        manifest_.clear();
+
+        std::vector<std::byte> header(calculate_header_size());
         std::uint64_t offset = 0;
-        write_header(buffer.data(), offset);
-        write_file_table(buffer.data(), offset);
-        write_file_data(buffer.data(), offset);
+        write_header(header.data(), offset);
+        write_file_table(header.data(), offset);
+        sink(header);
 
-        return buffer;
+        for (auto& entry : files_) {
+            write_entry(entry, offset, sink);
+        }
+
+        if (embeds_manifest()) {
+            std::string text = manifest_.to_string();
+            sink(std::as_bytes(std::span(text)));
+        }
     }
 
-    void ArchiveWriter::add_files_from_directory(const std::filesystem::path& dir,
-        const std::string& prefix,
-        std::function<bool(const std::filesystem::path&)> filter) {
-        if (!std::filesystem::exists(dir) || !std::filesystem::is_directory(dir)) {
-            return;
+    void ArchiveWriter::write_entry(FileEntry& entry, std::uint64_t& offset, const ChunkSink& sink) {
+        static constexpr std::array<std::byte, 4096> zeros{};
+        std::uint64_t aligned = align_up(offset, entry.align);
+        while (offset < aligned) {
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(aligned - offset, zeros.size()));
+            sink(std::span<const std::byte>(zeros.data(), n));
+            offset += n;
         }
+        entry.offset = offset;
+
+        // Hash each chunk on its way out, while it is hot in cache
+        bool hashing = manifest_mode_ != ManifestMode::None;
+        Crc32c crc;
+        std::uint64_t written = 0;
+        auto entry_sink = [&](std::span<const std::byte> chunk) {
+            if (chunk.empty()) {
+                return;
+            }
+            written += chunk.size();
+            if (written > entry.size) {
+                throw ArchiveException(std::format(
+                    "File '{}' produced more than its declared {} bytes", entry.path, entry.size));
+            }
+            if (hashing) {
+                crc.update(chunk);
+            }
+            sink(chunk);
+        };
 
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
-            if (entry.is_regular_file()) {
-                if (filter && !filter(entry.path())) {
-                    continue;
-                }
+        if (entry.source) {
+            entry.source(entry_sink);
+        }
+        else {
+            entry_sink(entry.data);
+        }
 
-                std::string archive_path = prefix + entry.path().lexically_relative(dir).string();
-                std::replace(archive_path.begin(), archive_path.end(), '\\', '/');
+        if (written != entry.size) {
+            throw ArchiveException(std::format(
+                "File '{}' produced {} bytes, {} were declared", entry.path, written, entry.size));
+        }
+        offset += entry.size;
 
-                add_file_from_disk(entry.path(), archive_path);
-            }
+        if (hashing) {
+            manifest_.add({ entry.path, entry.offset, entry.size, entry.align, crc.value() });
         }
     }
 
+    std::vector<std::byte> ArchiveWriter::write_to_memory() {
+        std::vector<std::byte> buffer;
+        buffer.reserve(total_size());
+        write([&buffer](std::span<const std::byte> chunk) {
+            buffer.insert(buffer.end(), chunk.begin(), chunk.end());
+        });
+        return buffer;
+    }
+
     bool ArchiveWriter::update_file(const std::string& path, std::span<const std::byte> new_data) {
-        auto it = files_.find(path);
-        if (it == files_.end()) {
+        auto it = file_index_.find(path);
+        if (it == file_index_.end()) {
             return false;
         }
 
-        it->second.data.assign(new_data.begin(), new_data.end());
+        FileEntry& entry = files_[it->second];
+        entry.data.assign(new_data.begin(), new_data.end());
+        entry.size = entry.data.size();
+        entry.source = nullptr;
         return true;
     }
 
@@ -0,0 +1,152 @@
+#include "compact_path_table.hpp"
+#include <algorithm>
+
+namespace RPFL {
+
+    namespace {
+
+        void put_varint(std::vector<char>& out, std::size_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        std::size_t get_varint(const char* data, std::size_t& pos) noexcept {
+            std::size_t value = 0;
+            for (int shift = 0; ; shift += 7) {
+                auto byte = static_cast<unsigned char>(data[pos++]);
+                value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+        }
+
+        std::size_t common_prefix(std::string_view a, std::string_view b) noexcept {
+            auto [ia, ib] = std::mismatch(a.begin(), a.end(), b.begin(), b.end());
+            return static_cast<std::size_t>(ia - a.begin());
+        }
+
+        // char_traits order, the one std::string_view sorting uses
+        bool char_less(char a, char b) noexcept {
+            return static_cast<unsigned char>(a) < static_cast<unsigned char>(b);
+        }
+
+    } // namespace
+
+    void CompactPathTable::build(std::span<const std::string_view> sorted_paths) {
+        clear();
+        count_ = sorted_paths.size();
+        restarts_.reserve((count_ + kBlockSize - 1) / kBlockSize);
+
+        std::string_view previous;
+        for (std::size_t i = 0; i < count_; ++i) {
+            std::string_view path = sorted_paths[i];
+            std::size_t shared = 0;
+            if (i % kBlockSize == 0) {
+                restarts_.push_back(bytes_.size());
+            }
+            else {
+                shared = common_prefix(previous, path);
+                put_varint(bytes_, shared);
+            }
+            put_varint(bytes_, path.size() - shared);
+            bytes_.insert(bytes_.end(), path.begin() + shared, path.end());
+            previous = path;
+        }
+        bytes_.shrink_to_fit();
+    }
+
+    void CompactPathTable::clear() noexcept {
+        bytes_.clear();
+        restarts_.clear();
+        count_ = 0;
+    }
+
+    std::string_view CompactPathTable::block_head(std::size_t block) const noexcept {
+        std::size_t pos = restarts_[block];
+        std::size_t length = get_varint(bytes_.data(), pos);
+        return { bytes_.data() + pos, length };
+    }
+
+    std::size_t CompactPathTable::decode_entry(std::size_t pos, bool head, std::string& path) const {
+        std::size_t shared = head ? 0 : get_varint(bytes_.data(), pos);
+        std::size_t suffix = get_varint(bytes_.data(), pos);
+        path.resize(shared);
+        path.append(bytes_.data() + pos, suffix);
+        return pos + suffix;
+    }
+
+    std::size_t CompactPathTable::find(std::string_view path) const noexcept {
+        if (count_ == 0) {
+            return npos;
+        }
+
+        // Last block whose head is <= path
+        std::size_t low = 0;
+        std::size_t high = restarts_.size();
+        while (low < high) {
+            std::size_t mid = low + (high - low) / 2;
+            if (block_head(mid) <= path) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        if (low == 0) {
+            return npos;
+        }
+        std::size_t block = low - 1;
+
+        std::string_view head = block_head(block);
+        if (head == path) {
+            return block * kBlockSize;
+        }
+
+        // Walk the block comparing suffixes against the query: `matched` is the
+        // common prefix of the query and the current (smaller) path
+        std::size_t matched = common_prefix(head, path);
+        std::size_t pos = static_cast<std::size_t>(head.data() + head.size() - bytes_.data());
+        std::size_t last = std::min(count_, (block + 1) * kBlockSize);
+
+        for (std::size_t index = block * kBlockSize + 1; index < last; ++index) {
+            std::size_t shared = get_varint(bytes_.data(), pos);
+            std::size_t suffix_size = get_varint(bytes_.data(), pos);
+            std::string_view suffix(bytes_.data() + pos, suffix_size);
+            pos += suffix_size;
+
+            if (shared > matched) {
+                // Agrees with the previous path past the mismatch, still smaller
+                continue;
+            }
+            if (shared < matched) {
+                // Differs from the previous path before the mismatch, now larger
+                return npos;
+            }
+
+            std::string_view rest = path.substr(matched);
+            std::size_t common = common_prefix(suffix, rest);
+            if (common == suffix.size() && common == rest.size()) {
+                return index;
+            }
+            if (common == rest.size() ||
+                (common < suffix.size() && char_less(rest[common], suffix[common]))) {
+                return npos;
+            }
+            matched += common;
+        }
+        return npos;
+    }
+
+    void CompactPathTable::path_at(std::size_t index, std::string& out) const {
+        std::size_t block = index / kBlockSize;
+        std::size_t pos = restarts_[block];
+        for (std::size_t i = block * kBlockSize; i <= index; ++i) {
+            pos = decode_entry(pos, i == block * kBlockSize, out);
+        }
+    }
+
+} // namespace RPFL
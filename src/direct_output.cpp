@@ -0,0 +1,253 @@
+#include "direct_output.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace RPFL {
+
+    namespace {
+
+        std::byte* aligned_alloc_bytes(std::size_t alignment, std::size_t size) {
+#ifdef _WIN32
+            return static_cast<std::byte*>(_aligned_malloc(size, alignment));
+#else
+            return static_cast<std::byte*>(std::aligned_alloc(alignment, size));
+#endif
+        }
+
+        IOError io_error(const std::string& what, const std::string& filepath) {
+            return IOError(std::format("{} '{}': {}", what, filepath, std::strerror(errno)));
+        }
+
+    } // namespace
+
+    void DirectOutput::AlignedFree::operator()(std::byte* data) const noexcept {
+#ifdef _WIN32
+        _aligned_free(data);
+#else
+        std::free(data);
+#endif
+    }
+
+    DirectOutput::DirectOutput(const std::string& filepath, OutputMode mode)
+        : filepath_(filepath), mode_(mode) {
+#ifdef _WIN32
+        // No cache control here, plain sequential writes
+        mode_ = OutputMode::Buffered;
+        fd_ = ::_open(filepath.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+        if (mode_ == OutputMode::Direct) {
+            fd_ = ::open(filepath.c_str(), flags | O_DIRECT, 0644);
+            // Some file systems (tmpfs, some network mounts) refuse O_DIRECT
+            if (fd_ < 0 && errno == EINVAL) {
+                mode_ = OutputMode::DropCache;
+            }
+        }
+#else
+        if (mode_ == OutputMode::Direct) {
+            mode_ = OutputMode::DropCache;
+        }
+#endif
+        if (mode_ != OutputMode::Direct) {
+            fd_ = ::open(filepath.c_str(), flags, 0644);
+        }
+#endif
+        if (fd_ < 0) {
+            throw io_error("Failed to open file for writing", filepath);
+        }
+
+        if (mode_ == OutputMode::Direct) {
+            for (auto& buffer : buffers_) {
+                buffer.reset(aligned_alloc_bytes(kAlignment, kBufferSize));
+                if (!buffer) {
+                    throw std::bad_alloc();
+                }
+            }
+            flusher_ = std::jthread([this] { flusher(); });
+        }
+    }
+
+    DirectOutput::~DirectOutput() {
+        if (flusher_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            changed_.notify_all();
+            flusher_.join();
+        }
+        if (fd_ >= 0) {
+#ifdef _WIN32
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+    }
+
+    void DirectOutput::write(std::span<const std::byte> data) {
+        if (mode_ != OutputMode::Direct) {
+            write_at(data.data(), data.size(), written_);
+            written_ += data.size();
+            drop_written();
+            return;
+        }
+
+        while (!data.empty()) {
+            std::size_t n = std::min(data.size(), kBufferSize - filled_);
+            std::memcpy(buffers_[current_].get() + filled_, data.data(), n);
+            filled_ += n;
+            data = data.subspan(n);
+            if (filled_ == kBufferSize) {
+                submit(kBufferSize);
+            }
+        }
+    }
+
+    void DirectOutput::finish() {
+        if (mode_ == OutputMode::Direct) {
+            // The tail goes out padded to the alignment, then the file is cut back
+            std::uint64_t size = written_ + filled_;
+            if (filled_ > 0) {
+                std::size_t padded = (filled_ + kAlignment - 1) & ~(kAlignment - 1);
+                std::memset(buffers_[current_].get() + filled_, 0, padded - filled_);
+                submit(padded);
+            }
+            wait_idle();
+#ifndef _WIN32
+            if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+                throw io_error("Failed to set the size of", filepath_);
+            }
+#endif
+            written_ = size;
+        }
+
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+        if (mode_ == OutputMode::DropCache) {
+            if (::fdatasync(fd_) != 0) {
+                throw io_error("Failed to flush", filepath_);
+            }
+            ::posix_fadvise(fd_, static_cast<off_t>(dropped_), 0, POSIX_FADV_DONTNEED);
+            dropped_ = written_;
+        }
+#endif
+
+#ifdef _WIN32
+        int result = ::_close(fd_);
+#else
+        int result = ::close(fd_);
+#endif
+        fd_ = -1;
+        if (result != 0) {
+            throw io_error("Failed to close", filepath_);
+        }
+    }
+
+    void DirectOutput::submit(std::size_t size) {
+        wait_idle();
+        {
+            std::lock_guard lock(mutex_);
+            job_data_ = buffers_[current_].get();
+            job_size_ = size;
+            job_offset_ = written_;
+            busy_ = true;
+        }
+        changed_.notify_all();
+        written_ += size;
+        current_ ^= 1;
+        filled_ = 0;
+    }
+
+    void DirectOutput::wait_idle() {
+        std::unique_lock lock(mutex_);
+        changed_.wait(lock, [this] { return !busy_; });
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+    void DirectOutput::flusher() {
+        std::unique_lock lock(mutex_);
+        for (;;) {
+            changed_.wait(lock, [this] { return busy_ || stop_; });
+            if (!busy_) {
+                return;
+            }
+
+            lock.unlock();
+            try {
+                write_at(job_data_, job_size_, job_offset_);
+            }
+            catch (...) {
+                lock.lock();
+                error_ = std::current_exception();
+                lock.unlock();
+            }
+            lock.lock();
+            busy_ = false;
+            changed_.notify_all();
+        }
+    }
+
+    void DirectOutput::write_at(const std::byte* data, std::size_t size, std::uint64_t offset) {
+        while (size > 0) {
+#ifdef _WIN32
+            (void)offset;
+            int count = ::_write(fd_, data, static_cast<unsigned>(std::min<std::size_t>(size, 1u << 30)));
+#else
+            ssize_t count = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+#endif
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw io_error("Failed to write", filepath_);
+            }
+            data += count;
+            size -= static_cast<std::size_t>(count);
+            offset += static_cast<std::uint64_t>(count);
+        }
+    }
+
+    void DirectOutput::drop_written() {
+        if (mode_ != OutputMode::DropCache) {
+            return;
+        }
+#if defined(__linux__)
+        // Start writeback of the newest window, then wait for the one before
+        // it to reach the disk and drop it: clean pages are all DONTNEED frees
+        while (written_ - dropped_ >= 2 * kDropWindow) {
+            auto window = static_cast<off_t>(kDropWindow);
+            ::sync_file_range(fd_, static_cast<off_t>(dropped_) + window, window, SYNC_FILE_RANGE_WRITE);
+            ::sync_file_range(fd_, static_cast<off_t>(dropped_), window,
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            ::posix_fadvise(fd_, static_cast<off_t>(dropped_), window, POSIX_FADV_DONTNEED);
+            dropped_ += kDropWindow;
+        }
+#elif !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+        if (written_ - dropped_ >= kDropWindow) {
+            ::fdatasync(fd_);
+            ::posix_fadvise(fd_, static_cast<off_t>(dropped_),
+                static_cast<off_t>(written_ - dropped_), POSIX_FADV_DONTNEED);
+            dropped_ = written_;
+        }
+#endif
+    }
+
+} // namespace RPFL
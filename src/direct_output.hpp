@@ -0,0 +1,71 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+
+#include "archive_writer.hpp"
+
+namespace RPFL {
+
+    // Sequential file output that keeps the written data out of the page
+    // cache, see OutputMode. Call finish() to flush, otherwise the file is
+    // left incomplete.
+    class DirectOutput {
+    public:
+        static constexpr std::size_t kAlignment = 4096;
+        static constexpr std::size_t kBufferSize = 4 * 1024 * 1024;
+        // DropCache writes back and drops the file in windows of this size
+        static constexpr std::uint64_t kDropWindow = 8 * 1024 * 1024;
+
+        DirectOutput(const std::string& filepath, OutputMode mode);
+        ~DirectOutput();
+
+        DirectOutput(const DirectOutput&) = delete;
+        DirectOutput& operator=(const DirectOutput&) = delete;
+
+        void write(std::span<const std::byte> data);
+        void finish();
+
+        // Direct falls back to DropCache where O_DIRECT is refused
+        OutputMode mode() const noexcept { return mode_; }
+
+    private:
+        struct AlignedFree {
+            void operator()(std::byte* data) const noexcept;
+        };
+        using Buffer = std::unique_ptr<std::byte, AlignedFree>;
+
+        void submit(std::size_t size);
+        void wait_idle();
+        void write_at(const std::byte* data, std::size_t size, std::uint64_t offset);
+        void drop_written();
+        void flusher();
+
+        std::string filepath_;
+        OutputMode mode_;
+        int fd_ = -1;
+        std::uint64_t written_ = 0; // handed to the OS
+        std::uint64_t dropped_ = 0; // DropCache: dropped from the cache so far
+
+        // Direct: one buffer filling while the flusher writes the other
+        Buffer buffers_[2];
+        std::size_t current_ = 0;
+        std::size_t filled_ = 0;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        const std::byte* job_data_ = nullptr;
+        std::size_t job_size_ = 0;
+        std::uint64_t job_offset_ = 0;
+        bool busy_ = false;
+        bool stop_ = false;
+        std::exception_ptr error_;
+        std::jthread flusher_;
+    };
+
+} // namespace RPFL
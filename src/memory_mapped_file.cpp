@@ -1,5 +1,6 @@
 #include "memory_mapped_file.hpp"
 #include "archive_exception.hpp"
+#include "archive_stats.hpp"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -22,14 +23,22 @@ namespace RPFL {
     }
 
     MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+#ifdef _WIN32
         : file_handle_(other.file_handle_)
         , mapping_handle_(other.mapping_handle_)
+#else
+        : file_descriptor_(other.file_descriptor_)
+#endif
         , mapped_data_(other.mapped_data_)
         , mapped_size_(other.mapped_size_)
         , options_(other.options_) {
 
+#ifdef _WIN32
         other.file_handle_ = nullptr;
         other.mapping_handle_ = nullptr;
+#else
+        other.file_descriptor_ = -1;
+#endif
         other.mapped_data_ = nullptr;
         other.mapped_size_ = 0;
     }
@@ -38,14 +47,22 @@ namespace RPFL {
         if (this != &other) {
             close();
 
+#ifdef _WIN32
             file_handle_ = other.file_handle_;
             mapping_handle_ = other.mapping_handle_;
+#else
+            file_descriptor_ = other.file_descriptor_;
+#endif
             mapped_data_ = other.mapped_data_;
             mapped_size_ = other.mapped_size_;
             options_ = other.options_;
 
+#ifdef _WIN32
             other.file_handle_ = nullptr;
             other.mapping_handle_ = nullptr;
+#else
+            other.file_descriptor_ = -1;
+#endif
             other.mapped_data_ = nullptr;
             other.mapped_size_ = 0;
         }
@@ -121,6 +138,8 @@ namespace RPFL {
             madvise(mapped_data_, mapped_size_, MADV_WILLNEED);
         }
 #endif
+        detail::count(detail::Maps);
+        detail::count(detail::BytesMapped, mapped_size_);
     }
 
     void MemoryMappedFile::close() {
@@ -0,0 +1,260 @@
+#include "pack_pipeline.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace RPFL {
+
+    namespace {
+
+        std::vector<std::byte> read_source(const std::filesystem::path& source) {
+            std::error_code error;
+            std::uint64_t size = std::filesystem::file_size(source, error);
+            if (error) {
+                throw IOError(std::format("Failed to stat '{}': {}", source.string(), error.message()));
+            }
+
+            std::ifstream file(source, std::ios::binary);
+            std::vector<std::byte> data(static_cast<std::size_t>(size));
+            if (!file || !file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size))) {
+                throw IOError("Failed to read file: " + source.string());
+            }
+            return data;
+        }
+
+        // State shared by the three stages, all under one mutex
+        struct PipelineState {
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::deque<std::pair<std::size_t, std::vector<std::byte>>> read_queue;
+            std::map<std::size_t, std::vector<std::byte>> results;
+            std::size_t written = 0; // items the writer stage is done with
+            bool reading_done = false;
+            bool stop = false;
+            std::exception_ptr error;
+
+            void fail(std::exception_ptr exception) {
+                {
+                    std::lock_guard lock(mutex);
+                    if (!error) {
+                        error = exception;
+                    }
+                    stop = true;
+                }
+                changed.notify_all();
+            }
+        };
+
+    } // namespace
+
+    PackPipeline::PackPipeline(ArchiveWriter& writer, PackOptions options)
+        : writer_(writer), options_(options) {
+    }
+
+    void PackPipeline::add(std::filesystem::path source, std::string path, std::uint32_t alignment) {
+        items_.push_back({ std::move(source), std::move(path), alignment });
+    }
+
+    PackStats PackPipeline::run(const std::string& filepath) {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw IOError("Failed to open file for writing: " + filepath);
+        }
+        PackStats stats = run(file);
+
+        if (writer_.manifest_mode_ == ManifestMode::Sidecar) {
+            writer_.manifest_.save(filepath + ".manifest");
+        }
+        return stats;
+    }
+
+    PackStats PackPipeline::run(std::ostream& stream) {
+        if (writer_.embeds_manifest() && writer_.contains(std::string(ArchiveManifest::kEmbeddedPath))) {
+            throw ArchiveException(std::format("'{}' is reserved for the embedded manifest",
+                ArchiveManifest::kEmbeddedPath));
+        }
+
+        std::streamoff start = stream.tellp();
+        if (start < 0) {
+            throw IOError("Pack output must be seekable");
+        }
+
+        // The items become writer entries for this run only, sized as they are written
+        const std::size_t base = writer_.files_.size();
+        struct Rollback {
+            ArchiveWriter& writer;
+            std::size_t base;
+            ~Rollback() {
+                for (std::size_t i = base; i < writer.files_.size(); ++i) {
+                    writer.file_index_.erase(writer.files_[i].path);
+                }
+                writer.files_.resize(base);
+            }
+        } rollback{ writer_, base };
+
+        for (const auto& item : items_) {
+            ArchiveWriter::FileEntry entry;
+            entry.path = item.path;
+            writer_.add_entry(std::move(entry), item.alignment);
+        }
+
+        auto sink = [&stream](std::span<const std::byte> chunk) {
+            stream.write(reinterpret_cast<const char*>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size()));
+            if (!stream) {
+                throw IOError("Failed to write archive data");
+            }
+        };
+
+        // Header and table take the same room whatever the sizes, reserve it now
+        std::vector<std::byte> header(static_cast<std::size_t>(writer_.calculate_header_size()));
+        sink(header);
+        std::uint64_t offset = header.size();
+
+        writer_.manifest_.clear();
+        for (std::size_t i = 0; i < base; ++i) {
+            writer_.write_entry(writer_.files_[i], offset, sink);
+        }
+
+        PackStats stats;
+        PipelineState state;
+        unsigned threads = resolve_thread_count(options_.threads);
+        std::size_t depth = options_.queue_depth > 0 ? options_.queue_depth : 2 * std::size_t{ threads };
+
+        {
+            std::jthread reader([&] {
+                try {
+                    for (std::size_t i = 0; i < items_.size(); ++i) {
+                        {
+                            std::unique_lock lock(state.mutex);
+                            state.changed.wait(lock, [&] { return state.stop || i < state.written + depth; });
+                            if (state.stop) {
+                                return;
+                            }
+                        }
+
+                        std::vector<std::byte> data = read_source(items_[i].source);
+                        {
+                            std::lock_guard lock(state.mutex);
+                            stats.input_bytes += data.size();
+                            state.read_queue.emplace_back(i, std::move(data));
+                        }
+                        state.changed.notify_all();
+                    }
+                    {
+                        std::lock_guard lock(state.mutex);
+                        state.reading_done = true;
+                    }
+                    state.changed.notify_all();
+                }
+                catch (...) {
+                    state.fail(std::current_exception());
+                }
+            });
+
+            std::vector<std::jthread> transformers;
+            transformers.reserve(threads);
+            for (unsigned t = 0; t < threads; ++t) {
+                transformers.emplace_back([&] {
+                    try {
+                        for (;;) {
+                            std::pair<std::size_t, std::vector<std::byte>> work;
+                            {
+                                std::unique_lock lock(state.mutex);
+                                state.changed.wait(lock, [&] {
+                                    return state.stop || !state.read_queue.empty() || state.reading_done;
+                                });
+                                if (state.stop || state.read_queue.empty()) {
+                                    return;
+                                }
+                                work = std::move(state.read_queue.front());
+                                state.read_queue.pop_front();
+                            }
+
+                            std::vector<std::byte> output = transform_
+                                ? transform_(items_[work.first], std::move(work.second))
+                                : std::move(work.second);
+                            {
+                                std::lock_guard lock(state.mutex);
+                                state.results.emplace(work.first, std::move(output));
+                            }
+                            state.changed.notify_all();
+                        }
+                    }
+                    catch (...) {
+                        state.fail(std::current_exception());
+                    }
+                });
+            }
+
+            // Writer stage on this thread, strictly in table order
+            try {
+                for (std::size_t i = 0; i < items_.size(); ++i) {
+                    ArchiveWriter::FileEntry& entry = writer_.files_[base + i];
+                    {
+                        std::unique_lock lock(state.mutex);
+                        state.changed.wait(lock, [&] {
+                            return state.stop || (!state.results.empty() && state.results.begin()->first == i);
+                        });
+                        if (state.stop) {
+                            break;
+                        }
+                        entry.data = std::move(state.results.begin()->second);
+                        state.results.erase(state.results.begin());
+                    }
+
+                    entry.size = entry.data.size();
+                    writer_.write_entry(entry, offset, sink);
+                    entry.data = {};
+                    stats.output_bytes += entry.size;
+                    ++stats.files;
+
+                    {
+                        std::lock_guard lock(state.mutex);
+                        ++state.written;
+                    }
+                    state.changed.notify_all();
+                }
+            }
+            catch (...) {
+                state.fail(std::current_exception());
+            }
+
+            {
+                std::lock_guard lock(state.mutex);
+                state.stop = true;
+            }
+            state.changed.notify_all();
+        }
+
+        if (state.error) {
+            std::rethrow_exception(state.error);
+        }
+
+        if (writer_.embeds_manifest()) {
+            std::string text = writer_.manifest_.to_string();
+            sink(std::as_bytes(std::span(text)));
+        }
+
+        // Every size is known now, go back and fill in the header and table
+        std::streamoff end = stream.tellp();
+        std::uint64_t header_offset = 0;
+        writer_.write_header(header.data(), header_offset);
+        writer_.write_file_table(header.data(), header_offset);
+        stream.seekp(start);
+        sink(header);
+        stream.seekp(end);
+        if (!stream) {
+            throw IOError("Failed to write archive header");
+        }
+        return stats;
+    }
+
+} // namespace RPFL
@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RPFL {
+
+    // 0 means one thread per hardware thread
+    inline unsigned resolve_thread_count(unsigned threads) noexcept {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        return std::max(1u, threads);
+    }
+
+    // Calls task(i) for every i in [0, count) on up to `threads` threads.
+    // Indices are handed out in increasing order, so work that is sorted by
+    // archive offset is read roughly front to back. The first exception
+    // stops further work and is rethrown on the calling thread.
+    template<typename Task>
+    void parallel_for(std::size_t count, unsigned threads, Task&& task) {
+        threads = static_cast<unsigned>(std::min<std::size_t>(resolve_thread_count(threads), count));
+        if (threads <= 1) {
+            for (std::size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto worker = [&] {
+            while (!failed.load(std::memory_order_relaxed)) {
+                std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= count) {
+                    return;
+                }
+                try {
+                    task(i);
+                }
+                catch (...) {
+                    std::lock_guard lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        {
+            std::vector<std::jthread> pool;
+            pool.reserve(threads - 1);
+            for (unsigned t = 1; t < threads; ++t) {
+                pool.emplace_back(worker);
+            }
+            worker();
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+} // namespace RPFL
@@ -0,0 +1,70 @@
+#include "path_filter.hpp"
+#include "path_utils.hpp"
+
+namespace RPFL {
+
+    namespace {
+
+        // splitmix64 finalizer, spreads the FNV bits before they pick block and bits
+        std::uint64_t mix(std::uint64_t h) noexcept {
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111ebull;
+            h ^= h >> 31;
+            return h;
+        }
+
+    } // namespace
+
+    std::size_t PathFilter::block_index(std::uint64_t hash) const noexcept {
+        // Multiply-shift range reduction of the high half
+        return static_cast<std::size_t>(((hash >> 32) * blocks_.size()) >> 32);
+    }
+
+    std::uint64_t PathFilter::probe_bits(std::uint64_t hash) noexcept {
+        // Re-stirred so the probes don't reuse the bits that chose the block;
+        // each probe takes 9 bits: word (3) + bit (6)
+        return hash * 0x9e3779b97f4a7c15ull;
+    }
+
+    std::uint64_t PathFilter::hash(std::string_view path) noexcept {
+        return mix(NormalizedPathHash{}(path));
+    }
+
+    std::uint64_t PathFilter::normalized_hash(std::string_view path) noexcept {
+        return mix(NormalizedPathHash{}(UnnormalizedPath{ path }));
+    }
+
+    void PathFilter::build(std::span<const std::uint64_t> hashes, std::size_t bits_per_path) {
+        std::size_t bits = hashes.size() * bits_per_path;
+        std::size_t block_count = bits / 512 + 1;
+        blocks_.assign(block_count, Block{});
+
+        for (std::uint64_t h : hashes) {
+            Block& block = blocks_[block_index(h)];
+            std::uint64_t probe = probe_bits(h);
+            for (int i = 0; i < kBitsPerBlockPath; ++i) {
+                block.words[(probe >> 6) & 7] |= std::uint64_t{ 1 } << (probe & 63);
+                probe >>= 9;
+            }
+        }
+    }
+
+    bool PathFilter::might_contain(std::uint64_t hash) const noexcept {
+        if (blocks_.empty()) {
+            return true;
+        }
+
+        const Block& block = blocks_[block_index(hash)];
+        std::uint64_t probe = probe_bits(hash);
+        for (int i = 0; i < kBitsPerBlockPath; ++i) {
+            if (!(block.words[(probe >> 6) & 7] & (std::uint64_t{ 1 } << (probe & 63)))) {
+                return false;
+            }
+            probe >>= 9;
+        }
+        return true;
+    }
+
+} // namespace RPFL
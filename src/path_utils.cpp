@@ -0,0 +1,92 @@
+#include "path_utils.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RPFL_PATH_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RPFL_PATH_NEON 1
+#endif
+
+namespace RPFL {
+
+    bool glob_match(std::string_view pattern, std::string_view path) noexcept {
+        while (!pattern.empty()) {
+            char c = pattern.front();
+            if (c == '*') {
+                bool any_depth = pattern.starts_with("**");
+                pattern.remove_prefix(any_depth ? 2 : 1);
+                // "**/" also stands for no directory at all: "a/**/b" matches "a/b"
+                if (any_depth && pattern.starts_with('/') && glob_match(pattern.substr(1), path)) {
+                    return true;
+                }
+                for (std::size_t i = 0; ; ++i) {
+                    if (glob_match(pattern, path.substr(i))) {
+                        return true;
+                    }
+                    if (i == path.size() || (!any_depth && path[i] == '/')) {
+                        return false;
+                    }
+                }
+            }
+
+            if (path.empty() || (c == '?' ? path.front() == '/' : c != path.front())) {
+                return false;
+            }
+            pattern.remove_prefix(1);
+            path.remove_prefix(1);
+        }
+        return path.empty();
+    }
+
+    std::string_view glob_literal_prefix(std::string_view pattern) noexcept {
+        return pattern.substr(0, pattern.find_first_of("*?"));
+    }
+
+    bool is_under_directory(std::string_view path, std::string_view dir) noexcept {
+        if (dir.empty()) {
+            return true;
+        }
+        if (!path.starts_with(dir)) {
+            return false;
+        }
+        return dir.back() == '/' || (path.size() > dir.size() && path[dir.size()] == '/');
+    }
+
+    void normalize_path(const char* src, char* dst, std::size_t size) noexcept {
+        std::size_t i = 0;
+#if defined(RPFL_PATH_SSE2)
+        const __m128i before_a = _mm_set1_epi8('A' - 1);
+        const __m128i after_z = _mm_set1_epi8('Z' + 1);
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i slash = _mm_set1_epi8('/');
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            // Signed compares: bytes >= 0x80 are negative and never count as upper case
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before_a), _mm_cmplt_epi8(v, after_z));
+            v = _mm_or_si128(v, _mm_and_si128(upper, case_bit));
+            __m128i is_backslash = _mm_cmpeq_epi8(v, backslash);
+            v = _mm_or_si128(_mm_andnot_si128(is_backslash, v), _mm_and_si128(is_backslash, slash));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        }
+#elif defined(RPFL_PATH_NEON)
+        const uint8x16_t a = vdupq_n_u8('A');
+        const uint8x16_t z = vdupq_n_u8('Z');
+        const uint8x16_t case_bit = vdupq_n_u8(0x20);
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const uint8x16_t slash = vdupq_n_u8('/');
+        for (; i + 16 <= size; i += 16) {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(src + i));
+            uint8x16_t upper = vandq_u8(vcgeq_u8(v, a), vcleq_u8(v, z));
+            v = vorrq_u8(v, vandq_u8(upper, case_bit));
+            v = vbslq_u8(vceqq_u8(v, backslash), slash, v);
+            vst1q_u8(reinterpret_cast<std::uint8_t*>(dst + i), v);
+        }
+#endif
+        for (; i < size; ++i) {
+            dst[i] = fold_path_char(src[i]);
+        }
+    }
+
+} // namespace RPFL
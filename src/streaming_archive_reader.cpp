@@ -0,0 +1,194 @@
+#include "streaming_archive_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace RPFL {
+
+    namespace {
+
+        StreamingArchiveReader::ReadFunction read_stream(std::istream& stream) {
+            return [&stream](std::span<std::byte> buffer) -> std::size_t {
+                stream.read(reinterpret_cast<char*>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size()));
+                if (stream.bad()) {
+                    throw IOError("Failed to read archive stream");
+                }
+                return static_cast<std::size_t>(stream.gcount());
+            };
+        }
+
+        StreamingArchiveReader::ReadFunction read_descriptor(int fd) {
+            return [fd](std::span<std::byte> buffer) -> std::size_t {
+                for (;;) {
+#ifdef _WIN32
+                    int count = ::_read(fd, buffer.data(),
+                        static_cast<unsigned>(std::min<std::size_t>(buffer.size(), 1u << 30)));
+#else
+                    ssize_t count = ::read(fd, buffer.data(), buffer.size());
+#endif
+                    if (count >= 0) {
+                        return static_cast<std::size_t>(count);
+                    }
+                    if (errno != EINTR) {
+                        throw IOError(std::format("Failed to read archive stream: {}", std::strerror(errno)));
+                    }
+                }
+            };
+        }
+
+    } // namespace
+
+    StreamingArchiveReader::StreamingArchiveReader(std::istream& stream,
+        Endianness file_endianness, std::size_t chunk_size)
+        : StreamingArchiveReader(read_stream(stream), file_endianness, chunk_size) {
+    }
+
+    StreamingArchiveReader::StreamingArchiveReader(int fd,
+        Endianness file_endianness, std::size_t chunk_size)
+        : StreamingArchiveReader(read_descriptor(fd), file_endianness, chunk_size) {
+    }
+
+    StreamingArchiveReader::StreamingArchiveReader(ReadFunction read,
+        Endianness file_endianness, std::size_t chunk_size)
+        : read_(std::move(read))
+        , file_endianness_(file_endianness)
+        , buffer_(std::max<std::size_t>(chunk_size, 1))
+        , current_(kNoEntry) {
+        parse_table();
+    }
+
+    void StreamingArchiveReader::parse_table() {
+        std::byte offset_bytes[sizeof(std::uint32_t)];
+        read_exact(offset_bytes, sizeof(offset_bytes));
+        std::uint32_t data_offset = read_with_endianness<std::uint32_t>(offset_bytes, file_endianness_);
+        if (data_offset < sizeof(offset_bytes)) {
+            throw ArchiveFormatException("Data offset points into the header");
+        }
+
+        // Header and table end before data_offset, read them in one go
+        std::vector<std::byte> table(data_offset - sizeof(offset_bytes));
+        read_exact(table.data(), table.size());
+
+        std::size_t pos = 0;
+        auto need = [&](std::uint64_t size, const char* what) {
+            if (size > table.size() - pos) {
+                throw ArchiveFormatException(what);
+            }
+        };
+        auto read_u64 = [&](const char* what) {
+            need(sizeof(std::uint64_t), what);
+            auto value = read_with_endianness<std::uint64_t>(table.data() + pos, file_endianness_);
+            pos += sizeof(value);
+            return value;
+        };
+        auto read_string = [&](const char* what) {
+            std::uint64_t length = read_u64(what);
+            need(length, what);
+            std::string_view text(reinterpret_cast<const char*>(table.data() + pos), length);
+            pos += length;
+            return text;
+        };
+
+        identifier_ = read_string("Identifier extends beyond data offset");
+        version_ = read_string("Version extends beyond data offset");
+
+        std::uint64_t num_files = read_u64("Incomplete file count");
+        // Each entry takes at least its two lengths and alignment
+        constexpr std::size_t kMinEntrySize = 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+        if (num_files > (table.size() - pos) / kMinEntrySize) {
+            throw ArchiveFormatException("File table extends beyond data offset");
+        }
+        entries_.reserve(static_cast<std::size_t>(num_files));
+        path_storage_.reserve(table.size() - pos);
+
+        std::uint64_t current_offset = data_offset;
+        for (std::uint64_t i = 0; i < num_files; ++i) {
+            std::string_view path = read_string("File path extends beyond data offset");
+            std::size_t stored_at = path_storage_.size();
+            path_storage_.insert(path_storage_.end(), path.begin(), path.end());
+
+            std::uint64_t file_size = read_u64("Incomplete file length");
+            need(sizeof(std::uint32_t), "Incomplete file alignment");
+            std::uint32_t file_align = read_with_endianness<std::uint32_t>(table.data() + pos, file_endianness_);
+            pos += sizeof(file_align);
+
+            current_offset = align_up(current_offset, file_align);
+            entries_.push_back({ std::string_view(path_storage_.data() + stored_at, path.size()),
+                current_offset, file_size, std::max<std::uint32_t>(file_align, 1) });
+            current_offset += file_size;
+        }
+    }
+
+    const StreamingArchiveReader::Entry* StreamingArchiveReader::next() {
+        if (current_ == entries_.size()) {
+            return nullptr;
+        }
+
+        discard(remaining_);
+        current_ = current_ == kNoEntry ? 0 : current_ + 1;
+        if (current_ == entries_.size()) {
+            remaining_ = 0;
+            return nullptr;
+        }
+
+        // Alignment padding before the entry
+        const Entry& entry = entries_[current_];
+        discard(entry.offset - position_);
+        remaining_ = entry.size;
+        return &entry;
+    }
+
+    const StreamingArchiveReader::Entry* StreamingArchiveReader::current() const noexcept {
+        return current_ < entries_.size() ? &entries_[current_] : nullptr;
+    }
+
+    std::span<const std::byte> StreamingArchiveReader::read_chunk() {
+        std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, buffer_.size()));
+        read_exact(buffer_.data(), size);
+        remaining_ -= size;
+        return { buffer_.data(), size };
+    }
+
+    std::size_t StreamingArchiveReader::read(std::span<std::byte> buffer) {
+        std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, buffer.size()));
+        read_exact(buffer.data(), size);
+        remaining_ -= size;
+        return size;
+    }
+
+    std::vector<std::byte> StreamingArchiveReader::read_all() {
+        std::vector<std::byte> data(static_cast<std::size_t>(remaining_));
+        read_exact(data.data(), data.size());
+        remaining_ = 0;
+        return data;
+    }
+
+    void StreamingArchiveReader::read_exact(std::byte* data, std::size_t size) {
+        while (size > 0) {
+            std::size_t count = read_({ data, size });
+            if (count == 0) {
+                throw ArchiveFormatException(std::format("Archive stream ends at byte {}", position_));
+            }
+            data += count;
+            size -= count;
+            position_ += count;
+        }
+    }
+
+    void StreamingArchiveReader::discard(std::uint64_t size) {
+        while (size > 0) {
+            std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(size, buffer_.size()));
+            read_exact(buffer_.data(), count);
+            size -= count;
+        }
+    }
+
+} // namespace RPFL
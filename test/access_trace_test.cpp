@@ -0,0 +1,96 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <thread>
+
+// rpfl_access_trace_test: a recorded trace loads back as written, and the
+// loader renumbers any thread value densely and rejects out of range paths
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    void put_varint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    // Hand-made trace over one path, a Lookup record per (thread, path) pair
+    void write_trace(const std::string& filepath,
+        std::initializer_list<std::pair<std::uint64_t, std::uint64_t>> records) {
+        std::string out = "RPFLTRC1";
+        out += '\0';
+        put_varint(out, 5);
+        out += "a.txt";
+        for (auto [thread, path] : records) {
+            out += static_cast<char>(0x01 + static_cast<int>(TraceOp::Lookup));
+            put_varint(out, 10);
+            put_varint(out, thread);
+            put_varint(out, path);
+            put_varint(out, 0);
+            put_varint(out, 0);
+        }
+        std::ofstream(filepath, std::ios::binary).write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+
+    bool rejects(const std::string& filepath) {
+        try {
+            load_access_trace(filepath);
+        }
+        catch (const ArchiveFormatException&) {
+            return true;
+        }
+        return false;
+    }
+
+} // namespace
+
+int main() {
+    auto filepath = temp_path("rpfl_access_trace_test", ".trace");
+
+    {
+        AccessTraceRecorder recorder(filepath);
+        recorder.record(TraceOp::Lookup, "a.txt", 0, 0);
+        {
+            // Both alive at once, a joined thread's id may be reused
+            std::latch started(2);
+            std::jthread first([&] { started.arrive_and_wait(); recorder.record(TraceOp::ReadChunk, "b.bin", 16, 32); });
+            std::jthread second([&] { started.arrive_and_wait(); recorder.record(TraceOp::ReadChunk, "b.bin", 16, 32); });
+        }
+        recorder.flush();
+        check(!recorder.failed() && recorder.record_count() == 3, "recorder");
+    }
+    {
+        AccessTrace trace = load_access_trace(filepath);
+        bool ok = trace.records.size() == 3 && trace.thread_count == 3 && trace.paths.size() == 2
+            && trace.records[0].thread == 0
+            && trace.records[1].thread + trace.records[2].thread == 3;
+        check(ok, "recorded threads and paths load back");
+        check(trace.records[1].op == TraceOp::ReadChunk && trace.paths[trace.records[1].path] == "b.bin"
+            && trace.records[1].offset == 16 && trace.records[1].size == 32, "record fields");
+    }
+
+    write_trace(filepath, { { 0xFFFFFFFF, 0 }, { 5, 0 }, { 1ull << 40, 0 }, { 0xFFFFFFFF, 0 } });
+    {
+        AccessTrace trace = load_access_trace(filepath);
+        bool dense = trace.thread_count == 3 && trace.records.size() == 4
+            && trace.records[0].thread == 0 && trace.records[1].thread == 1
+            && trace.records[2].thread == 2 && trace.records[3].thread == 0;
+        check(dense, "sparse and huge thread values are numbered densely");
+    }
+
+    // 2^32 would wrap to path 0 if cast before the check
+    write_trace(filepath, { { 0, 1ull << 32 } });
+    check(rejects(filepath), "path index past 32 bits is rejected");
+    write_trace(filepath, { { 0, 1 } });
+    check(rejects(filepath), "undefined path is rejected");
+
+    std::filesystem::remove(filepath);
+    return finish();
+}
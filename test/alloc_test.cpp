@@ -0,0 +1,111 @@
+#include "RPFL.h"
+#include "bench_common.hpp"
+#include "test_common.hpp"
+#include <cstdio>
+#include <filesystem>
+
+// rpfl_alloc_test: the read hot paths must not touch the heap. Linked with
+// bench/alloc_counter.cpp, which counts every global operator new.
+
+namespace {
+
+    using namespace RPFL;
+
+    constexpr int kIterations = 1000;
+    constexpr std::size_t kSmallSize = 2048;
+    constexpr std::size_t kLargeSize = 4 * 1024 * 1024; // above the cache threshold, streamed
+
+    int failures = 0;
+
+    // Allocations per call of op, averaged over kIterations calls
+    template<typename Op>
+    double allocations_per_call(Op&& op) {
+        op(); // first call may fill caches
+        std::uint64_t before = Bench::allocation_count();
+        for (int i = 0; i < kIterations; ++i) {
+            op();
+        }
+        return static_cast<double>(Bench::allocation_count() - before) / kIterations;
+    }
+
+    template<typename Op>
+    void expect_allocations(const char* name, double expected, Op&& op) {
+        double actual = allocations_per_call(op);
+        bool ok = actual == expected;
+        std::printf("%-4s %-40s %.2f allocations per call (expected %.0f)\n",
+            ok ? "ok" : "FAIL", name, actual, expected);
+        failures += ok ? 0 : 1;
+    }
+
+    void write_archive(const std::string& filepath) {
+        std::vector<std::byte> data(kLargeSize, std::byte{ 0x5A });
+        ArchiveWriter writer;
+        for (int i = 0; i < 64; ++i) {
+            writer.add_file("data/small" + std::to_string(i) + ".bin", std::span(data).first(kSmallSize));
+        }
+        writer.add_file("data/large.bin", data);
+        writer.write(filepath);
+    }
+
+    void check_lookups(ArchiveReader& reader, const char* mode) {
+        std::string name;
+        name = std::string("find/hit ") + mode;
+        expect_allocations(name.c_str(), 0, [&] { Bench::keep(reader.find("data/small7.bin")); });
+        name = std::string("find/miss ") + mode;
+        expect_allocations(name.c_str(), 0, [&] { Bench::keep(reader.find("data/missing.bin")); });
+        name = std::string("contains/literal ") + mode;
+        expect_allocations(name.c_str(), 0, [&] { Bench::keep(reader.contains("data/small7.bin")); });
+        name = std::string("get_file/literal ") + mode;
+        expect_allocations(name.c_str(), 0, [&] { Bench::keep(reader.get_file("data/small7.bin").size()); });
+    }
+
+} // namespace
+
+int main() {
+    auto filepath = RPFL::Test::temp_path("rpfl_alloc_test");
+    write_archive(filepath);
+
+    {
+        ArchiveReader reader(filepath);
+        check_lookups(reader, "(hash)");
+
+        expect_allocations("read_raw/literal", 0, [&] { Bench::keep(reader.read_raw("data/small7.bin").data()); });
+
+        auto& small = reader.get_file("data/small7.bin");
+        auto& large = reader.get_file("data/large.bin");
+        expect_allocations("data/cached", 0, [&] { Bench::keep(small.data().data()); });
+        expect_allocations("as_string_view/cached", 0, [&] { Bench::keep(small.as_string_view().data()); });
+        expect_allocations("as_string_view/streamed", 0, [&] { Bench::keep(large.as_string_view().data()); });
+        expect_allocations("raw_data", 0, [&] { Bench::keep(large.raw_data().data()); });
+
+        std::byte buffer[4096];
+        expect_allocations("read/small", 0, [&] { Bench::keep(small.read(100, buffer)); });
+        expect_allocations("read/streamed", 0, [&] { Bench::keep(large.read(kLargeSize / 2, buffer)); });
+
+        // Not zero, but must not grow with the entry
+        expect_allocations("read_chunk/streamed", 1, [&] { Bench::keep(large.read_chunk(kLargeSize / 2, 4096).data()); });
+        double small_stream = allocations_per_call([&] { Bench::keep(small.open_stream().get()); });
+        expect_allocations("open_stream/streamed (as small)", small_stream,
+            [&] { Bench::keep(large.open_stream().get()); });
+    }
+    {
+        ArchiveReader reader;
+        reader.set_compact_paths(true);
+        reader.open(filepath);
+        check_lookups(reader, "(compact)");
+    }
+    {
+        ArchiveReader reader;
+        reader.set_normalized_lookup(true);
+        reader.open(filepath);
+        check_lookups(reader, "(normalized)");
+        expect_allocations("find/folded (normalized)", 0, [&] { Bench::keep(reader.find("DATA\\Small7.BIN")); });
+    }
+
+    std::filesystem::remove(filepath);
+    if (failures != 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <random>
+
+// rpfl_diff_test: diff() sorts entries into added, removed, moved and changed;
+// equal-size entries are only paired as a move when their bytes agree, even
+// when size and CRC-32C do
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+    using Change = ArchiveDiff::Change;
+
+    constexpr std::size_t kSize = 100;
+
+    std::vector<std::byte> random_bytes(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::byte> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+        return data;
+    }
+
+    // Other bytes, same CRC-32C: the first byte is flipped and the last four
+    // are solved for, the CRC being affine in the message bits
+    std::vector<std::byte> crc_collision(std::vector<std::byte> data) {
+        std::size_t size = data.size();
+        auto delta = [size](std::size_t pos, unsigned bits) {
+            std::vector<std::byte> zero(size);
+            std::vector<std::byte> flipped(size);
+            flipped[pos] = static_cast<std::byte>(bits);
+            return crc32c(zero) ^ crc32c(flipped);
+        };
+
+        // basis[b]: CRC delta with top bit b, and the tail bits flipped for it
+        std::array<std::pair<std::uint32_t, std::uint32_t>, 32> basis{};
+        for (unsigned k = 0; k < 32; ++k) {
+            std::uint32_t d = delta(size - 4 + k / 8, 1u << (k % 8));
+            std::uint32_t mask = 1u << k;
+            for (int b = 31; b >= 0 && d != 0; --b) {
+                if ((d >> b & 1) == 0) {
+                    continue;
+                }
+                if (basis[b].first == 0) {
+                    basis[b] = { d, mask };
+                    break;
+                }
+                d ^= basis[b].first;
+                mask ^= basis[b].second;
+            }
+        }
+
+        std::uint32_t target = delta(0, 0xFF);
+        std::uint32_t flips = 0;
+        for (int b = 31; b >= 0; --b) {
+            if (target >> b & 1) {
+                target ^= basis[b].first;
+                flips ^= basis[b].second;
+            }
+        }
+        data[0] ^= std::byte{ 0xFF };
+        for (unsigned k = 0; k < 32; ++k) {
+            if (flips >> k & 1) {
+                data[size - 4 + k / 8] ^= static_cast<std::byte>(1u << (k % 8));
+            }
+        }
+        return data;
+    }
+
+    const ArchiveDiff::Entry* entry_for(const ArchiveDiff& result, std::string_view path) {
+        for (const auto& entry : result.entries) {
+            if ((entry.new_file && entry.new_file->path() == path) ||
+                (!entry.new_file && entry.old_file->path() == path)) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool is(const ArchiveDiff& result, std::string_view path, Change change,
+        std::string_view old_path = {}) {
+        const ArchiveDiff::Entry* entry = entry_for(result, path);
+        return entry && entry->change == change
+            && (old_path.empty() || (entry->old_file && entry->old_file->path() == old_path));
+    }
+
+} // namespace
+
+int main() {
+    auto old_path = temp_path("rpfl_diff_old");
+    auto new_path = temp_path("rpfl_diff_new");
+
+    // Every kSize entry below is a move candidate for every other
+    auto first = random_bytes(kSize, 1);
+    auto second = random_bytes(kSize, 2);
+    auto colliding = random_bytes(kSize, 3);
+    auto forged = crc_collision(colliding);
+    check(forged != colliding && crc32c(forged) == crc32c(colliding), "forged entry has the same CRC-32C");
+    {
+        ArchiveWriter writer;
+        writer.add_file("same.txt", "unchanged");
+        writer.add_file("edited.bin", random_bytes(500, 4));
+        writer.add_file("grown.bin", random_bytes(500, 5));
+        writer.add_file("old/first.bin", first);
+        writer.add_file("old/second.bin", second);
+        writer.add_file("old/colliding.bin", colliding);
+        writer.add_file("removed.bin", random_bytes(kSize, 6));
+        writer.write(old_path);
+    }
+    {
+        ArchiveWriter writer;
+        writer.add_file("same.txt", "unchanged");
+        writer.add_file("edited.bin", random_bytes(500, 7));
+        writer.add_file("grown.bin", random_bytes(600, 5));
+        // Added in the other order, so pairing by position would be wrong
+        writer.add_file("new/second.bin", second);
+        writer.add_file("new/first.bin", first);
+        writer.add_file("new/forged.bin", forged);
+        writer.add_file("added.bin", random_bytes(kSize, 8));
+        writer.write(new_path);
+    }
+
+    {
+        ArchiveReader old_archive(old_path);
+        ArchiveReader new_archive(new_path);
+        DiffOptions options;
+        options.threads = 3;
+        options.include_unchanged = true;
+        ArchiveDiff result = diff(old_archive, new_archive, options);
+
+        check(is(result, "same.txt", Change::Unchanged), "unchanged entry");
+        check(is(result, "edited.bin", Change::Changed), "same size, other bytes is changed");
+        check(is(result, "grown.bin", Change::Changed), "other size is changed");
+        check(is(result, "new/first.bin", Change::Moved, "old/first.bin"), "first equal-size move");
+        check(is(result, "new/second.bin", Change::Moved, "old/second.bin"), "second equal-size move");
+        check(is(result, "new/forged.bin", Change::Added), "same size and CRC, other bytes is added");
+        check(is(result, "old/colliding.bin", Change::Removed), "its CRC twin is removed");
+        check(is(result, "added.bin", Change::Added), "added entry");
+        check(is(result, "removed.bin", Change::Removed), "removed entry");
+        check(result.entries.size() == 9 && result.count(Change::Moved) == 2, "nothing else is reported");
+        check(std::ranges::is_sorted(result.entries, {}, [](const ArchiveDiff::Entry& entry) {
+            return entry.new_file ? entry.new_file->path() : entry.old_file->path();
+        }), "entries ordered by path");
+        check(result.to_string().find("M old/first.bin -> new/first.bin\n") != std::string::npos,
+            "move line");
+
+        options.include_unchanged = false;
+        check(!entry_for(diff(old_archive, new_archive, options), "same.txt"), "unchanged entries left out");
+    }
+
+    std::filesystem::remove(old_path);
+    std::filesystem::remove(new_path);
+    return finish();
+}
@@ -0,0 +1,90 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+#include <iterator>
+#include <random>
+
+// rpfl_file_stream_test: streams from ArchiveFile::open_stream() own what
+// they read, they must survive release_cache(), close(), a reopen and the
+// reader itself
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    constexpr std::size_t kCacheThreshold = 4096;
+
+    std::string random_text(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::string text(size, '\0');
+        for (char& c : text) {
+            c = static_cast<char>('a' + random() % 26);
+        }
+        return text;
+    }
+
+    std::string read_all(const std::shared_ptr<std::istream>& stream) {
+        stream->clear();
+        stream->seekg(0);
+        return { std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>() };
+    }
+
+    void write_archive(const std::string& filepath, std::uint64_t seed) {
+        ArchiveWriter writer;
+        writer.add_file("cached.txt", random_text(kCacheThreshold / 2, seed));
+        writer.add_file("large.txt", random_text(kCacheThreshold * 64, seed + 1));
+        writer.write(filepath);
+    }
+
+} // namespace
+
+int main() {
+    auto filepath = temp_path("rpfl_file_stream_test");
+    auto other_path = temp_path("rpfl_file_stream_other");
+    write_archive(filepath, 1);
+    write_archive(other_path, 2);
+    std::string cached = random_text(kCacheThreshold / 2, 1);
+    std::string large = random_text(kCacheThreshold * 64, 2);
+
+    for (bool streaming : { true, false }) {
+        std::string mode = streaming ? " (streaming)" : " (mapped view)";
+        auto reader = std::make_unique<ArchiveReader>(filepath, kCacheThreshold, true, streaming);
+        ArchiveFile& small = reader->get_file("cached.txt");
+        small.data();
+        check(small.is_cached(), "entry is cached" + mode);
+        auto small_stream = small.open_stream();
+        small.release_cache();
+        check(read_all(small_stream) == cached, "stream survives release_cache()" + mode);
+
+        auto large_stream = reader->get_file("large.txt").open_stream();
+        reader->open(other_path, kCacheThreshold, true, streaming);
+        check(read_all(large_stream) == large, "stream survives a reopen" + mode);
+
+        auto reopened_stream = reader->get_file("cached.txt").open_stream();
+        reader->close();
+        check(read_all(reopened_stream) == random_text(kCacheThreshold / 2, 2), "stream survives close()" + mode);
+
+        reader->open(filepath, kCacheThreshold, true, streaming);
+        large_stream = reader->get_file("large.txt").open_stream();
+        reader.reset();
+        check(read_all(large_stream) == large && read_all(small_stream) == cached,
+            "streams survive the reader" + mode);
+    }
+
+    {
+        // A moved file streams its own bytes, not the moved-from object's
+        auto bytes = std::make_shared<std::string>(random_text(kCacheThreshold * 2, 3));
+        ArchiveFile file("standalone.txt", 0, bytes->size(), reinterpret_cast<const std::byte*>(bytes->data()),
+            kCacheThreshold, true, 1, bytes);
+        ArchiveFile moved(std::move(file));
+        auto stream = moved.open_stream();
+        std::string expected = *bytes;
+        bytes.reset();
+        check(read_all(stream) == expected, "moved file streams its data, kept alive by data_owner");
+    }
+
+    std::filesystem::remove(filepath);
+    std::filesystem::remove(other_path);
+    return finish();
+}
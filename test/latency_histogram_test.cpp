@@ -0,0 +1,105 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <limits>
+
+// rpfl_latency_histogram_test: LatencyHistogram buckets tile [0, kMaxValue]
+// with every value landing in the bucket whose bounds hold it; larger values
+// clamp to the last bucket; percentiles, merge and subtract on known values
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+    using Histogram = LatencyHistogram;
+
+    Histogram range(std::uint64_t first, std::uint64_t last) {
+        Histogram histogram;
+        for (std::uint64_t ns = first; ns <= last; ++ns) {
+            histogram.record(ns);
+        }
+        return histogram;
+    }
+
+    bool same(const Histogram& a, const Histogram& b) {
+        return a.buckets() == b.buckets() && a.count() == b.count() && a.total_ns() == b.total_ns();
+    }
+
+} // namespace
+
+int main() {
+    {
+        bool bounded = true;
+        bool contiguous = Histogram::bucket_lower(0) == 0;
+        for (std::size_t i = 0; i < Histogram::kBucketCount; ++i) {
+            std::uint64_t lower = Histogram::bucket_lower(i);
+            std::uint64_t upper = Histogram::bucket_upper(i);
+            std::uint64_t middle = lower + (upper - lower) / 2;
+            bounded = bounded && lower <= upper && Histogram::bucket_index(lower) == i
+                && Histogram::bucket_index(middle) == i && Histogram::bucket_index(upper) == i;
+            contiguous = contiguous && (i == 0 || lower == Histogram::bucket_upper(i - 1) + 1);
+        }
+        check(bounded, "every bucket's lower, middle and upper value map to it");
+        check(contiguous && Histogram::bucket_upper(Histogram::kBucketCount - 1) == Histogram::kMaxValue,
+            "buckets cover [0, kMaxValue] without gaps");
+
+        // Width at most 1/kSubBuckets of the value, exact below kSubBuckets
+        bool precise = true;
+        for (std::size_t i = 0; i < Histogram::kBucketCount; ++i) {
+            std::uint64_t width = Histogram::bucket_upper(i) - Histogram::bucket_lower(i) + 1;
+            precise = precise && (i < Histogram::kSubBuckets ? width == 1
+                : width * Histogram::kSubBuckets <= Histogram::bucket_lower(i));
+        }
+        check(precise, "bucket width within 1/kSubBuckets of its values");
+    }
+    {
+        Histogram histogram;
+        histogram.record(Histogram::kMaxValue);
+        histogram.record(Histogram::kMaxValue + 1);
+        histogram.record(std::numeric_limits<std::uint64_t>::max());
+        check(Histogram::bucket_index(std::numeric_limits<std::uint64_t>::max()) == Histogram::kBucketCount - 1
+            && histogram.buckets().back() == 3 && histogram.count() == 3, "values past kMaxValue clamp");
+        check(histogram.max() == Histogram::kMaxValue && histogram.percentile(100) == Histogram::kMaxValue,
+            "clamped values report kMaxValue");
+    }
+    {
+        Histogram empty;
+        check(empty.percentile(50) == 0 && empty.min() == 0 && empty.max() == 0 && empty.mean() == 0.0,
+            "empty histogram");
+
+        Histogram exact = range(0, 31);
+        check(exact.percentile(0) == 0 && exact.percentile(50) == 15 && exact.percentile(100) == 31,
+            "percentiles exact below kSubBuckets");
+
+        // 1..1000 once each: percentile p is value 10 * p, reported as the
+        // upper bound of its bucket
+        Histogram histogram = range(1, 1000);
+        check(histogram.count() == 1000 && histogram.mean() == 500.5, "count and mean");
+        check(histogram.min() == 1 && histogram.max() == 1007, "min and max are bucket bounds");
+        check(histogram.percentile(0) == 1 && histogram.percentile(50) == 503
+            && histogram.percentile(90) == 911 && histogram.percentile(99) == 991
+            && histogram.percentile(100) == 1007, "percentiles of 1..1000");
+        check(histogram.percentile(-5) == histogram.percentile(0)
+            && histogram.percentile(250) == histogram.percentile(100), "percent clamped to [0, 100]");
+    }
+    {
+        Histogram all = range(1, 1000);
+        Histogram low = range(1, 500);
+        Histogram high = range(501, 1000);
+
+        Histogram merged = low;
+        merged.merge(high);
+        check(same(merged, all), "merge of two halves is the whole");
+
+        Histogram interval = all;
+        interval.subtract(low);
+        check(same(interval, high), "subtracting an earlier state leaves the interval");
+        interval.subtract(high);
+        check(same(interval, Histogram{}), "subtracting everything leaves nothing");
+
+        Histogram clamped = low;
+        clamped.subtract(all);
+        check(same(clamped, Histogram{}), "subtract never goes below zero");
+    }
+
+    return finish();
+}
@@ -0,0 +1,115 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+#include <set>
+
+// rpfl_overlay_test: after every mount and unmount the ArchiveOverlay index
+// must name the same winner as resolving each path from scratch
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    struct Mounted {
+        ArchiveOverlay::MountId id;
+        int priority;
+        std::shared_ptr<ArchiveReader> reader;
+    };
+
+    std::shared_ptr<ArchiveReader> make_reader(const std::string& filepath,
+        std::initializer_list<std::string_view> paths) {
+        ArchiveWriter writer;
+        for (std::string_view path : paths) {
+            writer.add_file(std::string(path), std::string(path) + " in " + filepath);
+        }
+        writer.write(filepath);
+        return std::make_shared<ArchiveReader>(filepath);
+    }
+
+    // Highest priority first, the newest mount on ties
+    const Mounted* brute_force_winner(const std::vector<Mounted>& mounted, std::string_view path) {
+        const Mounted* best = nullptr;
+        for (const auto& m : mounted) {
+            if (!m.reader->contains(path)) {
+                continue;
+            }
+            if (!best || m.priority > best->priority ||
+                (m.priority == best->priority && m.id > best->id)) {
+                best = &m;
+            }
+        }
+        return best;
+    }
+
+    void check_index(const ArchiveOverlay& overlay, const std::vector<Mounted>& mounted,
+        const std::set<std::string>& all_paths, const std::string& step) {
+        bool ok = true;
+        std::size_t expected_count = 0;
+        for (const auto& path : all_paths) {
+            const Mounted* winner = brute_force_winner(mounted, path);
+            const ArchiveOverlay::Entry* entry = overlay.find(path);
+            if (!winner) {
+                ok = ok && entry == nullptr;
+                continue;
+            }
+            ++expected_count;
+            ok = ok && entry != nullptr
+                && entry->mount == winner->id
+                && entry->reader == winner->reader.get()
+                && entry->file == winner->reader->find(path)
+                && entry->file->path() == path;
+        }
+        ok = ok && overlay.file_count() == expected_count && overlay.mount_count() == mounted.size();
+        check(ok, "winners " + step);
+    }
+
+} // namespace
+
+int main() {
+    std::vector<std::string> filepaths = {
+        temp_path("rpfl_overlay_a"), temp_path("rpfl_overlay_b"), temp_path("rpfl_overlay_c")
+    };
+    std::set<std::string> all_paths;
+    {
+        auto a = make_reader(filepaths[0], { "shared.txt", "ab.txt", "ac.txt", "only_a.txt" });
+        auto b = make_reader(filepaths[1], { "shared.txt", "ab.txt", "bc.txt", "only_b.txt" });
+        auto c = make_reader(filepaths[2], { "shared.txt", "ac.txt", "bc.txt", "only_c.txt" });
+        for (const auto& reader : { a, b, c }) {
+            for (const auto& file : reader->files()) {
+                all_paths.emplace(file->path());
+            }
+        }
+
+        ArchiveOverlay overlay;
+        std::vector<Mounted> mounted;
+        auto mount = [&](std::shared_ptr<ArchiveReader> reader, int priority, const char* step) {
+            mounted.push_back({ overlay.mount(reader, priority), priority, reader });
+            check_index(overlay, mounted, all_paths, step);
+            return mounted.back().id;
+        };
+        auto unmount = [&](ArchiveOverlay::MountId id, const char* step) {
+            check(overlay.unmount(id), std::string("unmounting ") + step);
+            std::erase_if(mounted, [id](const Mounted& m) { return m.id == id; });
+            check_index(overlay, mounted, all_paths, std::string("after unmounting ") + step);
+        };
+
+        // Ranks end up b (5), c (0, newer), a (0): c is the middle one
+        mount(a, 0, "after mounting a");
+        auto top = mount(b, 5, "after mounting b above a");
+        auto middle = mount(c, 0, "after mounting c, tied with a");
+
+        unmount(middle, "the middle mount");
+        unmount(top, "the top mount");
+        check(!overlay.unmount(top), "unmounting twice fails");
+
+        overlay.clear();
+        mounted.clear();
+        check_index(overlay, mounted, all_paths, "after clear");
+    }
+
+    for (const auto& filepath : filepaths) {
+        std::filesystem::remove(filepath);
+    }
+    return finish();
+}
@@ -0,0 +1,115 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+// rpfl_patch_test: create_patch() then apply_patch() must rebuild the new
+// archive byte for byte, and a damaged patch must be rejected
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    std::vector<std::byte> random_bytes(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::byte> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+        return data;
+    }
+
+    std::string read_file(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    }
+
+    // Applies patch to old_archive, the exception message if it throws
+    std::string apply(const ArchiveReader& old_archive, const std::string& patch, std::string& rebuilt) {
+        std::istringstream in(patch);
+        std::ostringstream out;
+        try {
+            apply_patch(old_archive, in, out);
+        }
+        catch (const ArchiveException& e) {
+            return e.what();
+        }
+        rebuilt = out.str();
+        return {};
+    }
+
+    bool rejects(const ArchiveReader& old_archive, const std::string& patch) {
+        std::string rebuilt;
+        return !apply(old_archive, patch, rebuilt).empty();
+    }
+
+} // namespace
+
+int main() {
+    auto old_path = temp_path("rpfl_patch_old");
+    auto new_path = temp_path("rpfl_patch_new");
+
+    auto shared = random_bytes(3000, 1);
+    auto moved = random_bytes(2000, 2);
+    auto base = random_bytes(64 * 1024, 3);
+    auto edited = base;
+    for (std::size_t i = 0; i < edited.size(); i += 8191) {
+        edited[i] = ~edited[i];
+    }
+    {
+        ArchiveWriter writer;
+        writer.add_file("unchanged.bin", random_bytes(5000, 4), 16);
+        writer.add_file("old/moved.bin", moved);
+        writer.add_file("delta.bin", base);
+        writer.add_file("literal.bin", random_bytes(1000, 5));
+        writer.add_file("removed.bin", random_bytes(700, 6));
+        writer.add_file("shared.bin", shared);
+        writer.write(old_path);
+    }
+    {
+        ArchiveWriter writer;
+        writer.add_file("unchanged.bin", random_bytes(5000, 4), 16);
+        writer.add_file("new/moved.bin", moved);
+        writer.add_file("delta.bin", edited);
+        writer.add_file("literal.bin", random_bytes(1000, 7));
+        writer.add_file("shared.bin", shared);
+        writer.add_file("copy_of_shared.bin", shared, 64);
+        writer.add_file("added.bin", random_bytes(900, 8));
+        writer.write(new_path);
+    }
+
+    {
+        ArchiveReader old_archive(old_path);
+        ArchiveReader new_archive(new_path);
+
+        std::ostringstream patch_out;
+        PatchStats stats = create_patch(old_archive, new_archive, patch_out);
+        std::string patch = patch_out.str();
+        check(stats.copied == 4, "unchanged, moved, kept and duplicated entries are copied");
+        check(stats.delta == 1, "edited entry is a delta");
+        check(stats.literal == 2, "rewritten and added entries are literal");
+        check(stats.patch_size == patch.size() && patch.size() < base.size(), "patch size");
+
+        std::string rebuilt;
+        std::string error = apply(old_archive, patch, rebuilt);
+        check(error.empty() && rebuilt == read_file(new_path), "applied patch matches the new archive");
+        check(stats.new_archive_size == rebuilt.size(), "new archive size");
+
+        // The last body is the literal added.bin, its CRC-32C catches the flip
+        std::string flipped = patch;
+        flipped.back() = static_cast<char>(~flipped.back());
+        check(rejects(old_archive, flipped), "flipped body byte is rejected");
+        check(rejects(old_archive, patch.substr(0, patch.size() - 1)), "truncated patch is rejected");
+        check(rejects(old_archive, patch + '\0'), "trailing data is rejected");
+        check(rejects(old_archive, "RPFLPAT0" + patch.substr(8)), "bad magic is rejected");
+        check(rejects(new_archive, patch), "patch against the wrong archive is rejected");
+    }
+
+    std::filesystem::remove(old_path);
+    std::filesystem::remove(new_path);
+    return finish();
+}
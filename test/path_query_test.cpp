@@ -0,0 +1,95 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+
+// rpfl_path_query_test: glob_match() semantics and the sorted-index queries
+// of ArchiveReader (list_dir, list_range, glob), folded with a normalized index
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    void expect_glob(std::string_view pattern, std::string_view path, bool expected) {
+        std::string name = std::string(pattern) + (expected ? " matches " : " rejects ") + std::string(path);
+        check(glob_match(pattern, path) == expected, name);
+    }
+
+    std::vector<std::string_view> paths_of(std::span<ArchiveFile* const> files) {
+        std::vector<std::string_view> paths;
+        for (const ArchiveFile* file : files) {
+            paths.push_back(file->path());
+        }
+        return paths;
+    }
+
+    using Paths = std::vector<std::string_view>;
+
+} // namespace
+
+int main() {
+    expect_glob("*.txt", "a.txt", true);
+    expect_glob("*.txt", "dir/a.txt", false);
+    expect_glob("?.txt", "a.txt", true);
+    expect_glob("?.txt", "/.txt", false);
+    expect_glob("**.txt", "dir/sub/a.txt", true);
+    expect_glob("a/**/b", "a/b", true);
+    expect_glob("a/**/b", "a/x/b", true);
+    expect_glob("a/**/b", "a/x/y/b", true);
+    expect_glob("a/**/b", "a/xb", false);
+    expect_glob("a/**/b", "ab", false);
+    expect_glob("**/b.txt", "b.txt", true);
+    expect_glob("**/b.txt", "x/y/b.txt", true);
+    expect_glob("a/**", "a/x/y", true);
+    expect_glob("a/*/b", "a/b", false);
+
+    auto filepath = temp_path("rpfl_path_query_test");
+    {
+        ArchiveWriter writer;
+        for (const char* path : { "data/a.txt", "data/sub/b.txt", "data-x/c.txt", "data.txt", "other/d.bin" }) {
+            writer.add_file(path, path);
+        }
+        writer.write(filepath);
+    }
+    {
+        ArchiveReader reader(filepath);
+        check(paths_of(reader.list_dir("data")) == Paths{ "data/a.txt", "data/sub/b.txt" }, "list_dir(data)");
+        check(paths_of(reader.list_dir("data/")) == Paths{ "data/a.txt", "data/sub/b.txt" }, "list_dir(data/)");
+        check(paths_of(reader.list_dir("")).size() == 5, "list_dir of the root lists everything");
+        check(paths_of(reader.list_range("data/", "data0")) == Paths{ "data/a.txt", "data/sub/b.txt" },
+            "list_range");
+        std::vector<std::string_view> globbed;
+        for (const ArchiveFile* file : reader.glob("data/**/*.txt")) {
+            globbed.push_back(file->path());
+        }
+        check(globbed == Paths{ "data/a.txt", "data/sub/b.txt" }, "glob with ** over zero and one directory");
+    }
+
+    {
+        ArchiveWriter writer;
+        for (const char* path : { "Data/A.txt", "DATA/sub/B.txt", "data-x/c.txt", "Other/d.bin" }) {
+            writer.add_file(path, path);
+        }
+        writer.write(filepath);
+    }
+    {
+        ArchiveReader reader;
+        reader.open(filepath);
+        check(reader.list_dir("data").empty(), "literal list_dir keeps case");
+
+        reader.set_normalized_lookup(true);
+        reader.open(filepath);
+        Paths expected{ "Data/A.txt", "DATA/sub/B.txt" };
+        check(paths_of(reader.list_dir("data")) == expected, "normalized list_dir(data)");
+        check(paths_of(reader.list_dir("DATA\\")) == expected, "normalized list_dir(DATA\\)");
+        check(paths_of(reader.list_range("DATA/", "data0")) == expected, "normalized list_range");
+        std::vector<std::string_view> globbed;
+        for (const ArchiveFile* file : reader.glob("data\\**\\*.TXT")) {
+            globbed.push_back(file->path());
+        }
+        check(globbed == expected, "normalized glob");
+    }
+
+    std::filesystem::remove(filepath);
+    return finish();
+}
@@ -0,0 +1,142 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// rpfl_pipeline_test: PackPipeline must produce the same bytes as
+// ArchiveWriter for the same entries, keep at most queue_depth files past
+// the writer, and leave the writer as it was when a stage fails
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    constexpr std::size_t kItems = 12;
+    constexpr std::size_t kDepth = 2;
+
+    std::string item_path(std::size_t i) {
+        return "packed/item" + std::to_string(i) + ".bin";
+    }
+
+    std::uint32_t item_alignment(std::size_t i) {
+        return i % 3 == 0 ? 16 : 0;
+    }
+
+    std::vector<std::byte> item_data(std::size_t i) {
+        std::vector<std::byte> data(100 + i * 37);
+        for (std::size_t j = 0; j < data.size(); ++j) {
+            data[j] = static_cast<std::byte>(i * 31 + j);
+        }
+        return data;
+    }
+
+    // Output of the test transform, changes the size so the table must be back-patched
+    std::vector<std::byte> transformed(std::vector<std::byte> data) {
+        std::reverse(data.begin(), data.end());
+        data.resize(data.size() + data.size() % 5, std::byte{ 0xEE });
+        return data;
+    }
+
+    std::size_t item_index(const PackItem& item) {
+        return std::stoul(item.path.substr(item.path.find("item") + 4));
+    }
+
+    ArchiveWriter make_writer() {
+        ArchiveWriter writer;
+        writer.add_file("existing.txt", "written first, unchanged");
+        writer.add_file("aligned.bin", item_data(99), 64);
+        return writer;
+    }
+
+    PackPipeline make_pipeline(ArchiveWriter& writer, const std::filesystem::path& dir) {
+        PackOptions options;
+        options.threads = 3;
+        options.queue_depth = kDepth;
+        PackPipeline pipeline(writer, options);
+        for (std::size_t i = 0; i < kItems; ++i) {
+            pipeline.add(dir / ("source" + std::to_string(i) + ".bin"), item_path(i), item_alignment(i));
+        }
+        return pipeline;
+    }
+
+} // namespace
+
+int main() {
+    std::filesystem::path dir = temp_path("rpfl_pipeline_test", "");
+    std::filesystem::create_directories(dir);
+    for (std::size_t i = 0; i < kItems; ++i) {
+        auto data = item_data(i);
+        std::ofstream(dir / ("source" + std::to_string(i) + ".bin"), std::ios::binary)
+            .write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    ArchiveWriter expected_writer = make_writer();
+    for (std::size_t i = 0; i < kItems; ++i) {
+        expected_writer.add_file(item_path(i), transformed(item_data(i)), item_alignment(i));
+    }
+    auto expected = expected_writer.write_to_memory();
+
+    ArchiveWriter writer = make_writer();
+    const auto before = writer.write_to_memory();
+
+    {
+        // Item 0 is held in the transform, so nothing is written and the
+        // reader must stop kDepth items ahead
+        std::atomic<bool> first_done{ false };
+        std::atomic<bool> ran_ahead{ false };
+        PackPipeline pipeline = make_pipeline(writer, dir);
+        pipeline.set_transform([&](const PackItem& item, std::vector<std::byte> data) {
+            std::size_t index = item_index(item);
+            if (index == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                first_done = true;
+            }
+            else if (index >= kDepth && !first_done) {
+                ran_ahead = true;
+            }
+            return transformed(std::move(data));
+        });
+
+        std::ostringstream out;
+        PackStats stats = pipeline.run(out);
+        std::string packed = out.str();
+        check(packed.size() == expected.size()
+            && std::memcmp(packed.data(), expected.data(), expected.size()) == 0,
+            "pipeline output matches write_to_memory()");
+        check(stats.files == kItems, "every item is packed");
+        check(!ran_ahead, "reader stays within queue_depth of the writer");
+        check(writer.file_count() == 2 && writer.write_to_memory() == before,
+            "items are dropped from the writer after the run");
+    }
+    {
+        PackPipeline pipeline = make_pipeline(writer, dir);
+        pipeline.set_transform([](const PackItem& item, std::vector<std::byte> data) {
+            if (item_index(item) == 5) {
+                throw ArchiveException("transform failed");
+            }
+            return transformed(std::move(data));
+        });
+
+        std::ostringstream out;
+        bool threw = false;
+        try {
+            pipeline.run(out);
+        }
+        catch (const ArchiveException&) {
+            threw = true;
+        }
+        check(threw, "transform exception reaches the caller");
+        check(writer.file_count() == 2 && !writer.contains(item_path(0)) && writer.write_to_memory() == before,
+            "writer is unchanged after a failed run");
+    }
+
+    std::filesystem::remove_all(dir);
+    return finish();
+}
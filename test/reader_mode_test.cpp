@@ -0,0 +1,132 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+
+// rpfl_reader_mode_test: index settings changed on an open reader apply on
+// the next open(), lookups and the path filter keep using the index the
+// reader was opened with, and every index resolves duplicate paths alike
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    const char* const kPaths[] = { "a/b.txt", "a/c.txt", "d.txt" };
+
+    void write_archive(const std::string& filepath) {
+        ArchiveWriter writer;
+        for (const char* path : kPaths) {
+            writer.add_file(path, std::string("data of ") + path);
+        }
+        writer.write(filepath);
+    }
+
+    bool finds_all(const ArchiveReader& reader) {
+        bool ok = !reader.contains("a/missing.txt") && reader.find("a/missing.txt") == nullptr;
+        for (const char* path : kPaths) {
+            ArchiveFile* file = reader.find(path);
+            ok = ok && reader.contains(path) && file && file->path() == path
+                && reader.read_raw(path).size() == file->size();
+        }
+        return ok;
+    }
+
+    void check_toggle(const std::string& filepath, bool compact_at_open) {
+        std::string mode = compact_at_open ? "compact" : "hash";
+        ArchiveReader reader;
+        reader.set_compact_paths(compact_at_open);
+        reader.open(filepath);
+        check(finds_all(reader), "lookups opened as " + mode);
+
+        reader.set_compact_paths(!compact_at_open);
+        check(finds_all(reader), "lookups opened as " + mode + ", toggled while open");
+
+        reader.open(filepath);
+        check(finds_all(reader), "lookups reopened after toggling from " + mode);
+    }
+
+    // The Bloom filter and the lookups must hash paths the same way
+    void check_normalized_toggle(const std::string& filepath, bool normalized_at_open) {
+        std::string mode = normalized_at_open ? "normalized" : "literal";
+        auto reader = std::make_shared<ArchiveReader>();
+        reader->set_path_filter(true);
+        reader->set_normalized_lookup(normalized_at_open);
+        reader->open(filepath);
+        ArchiveSearchPath search_path;
+        search_path.add(reader);
+
+        auto finds_folded = [&] {
+            return reader->find("A\\B.TXT") != nullptr && search_path.contains("A\\B.TXT");
+        };
+        auto finds_exact = [&] {
+            bool ok = !search_path.contains("a/missing.txt");
+            for (const char* path : kPaths) {
+                ok = ok && search_path.find(path).file == reader->find(path);
+            }
+            return ok && finds_all(*reader);
+        };
+
+        check(finds_exact() && finds_folded() == normalized_at_open, "lookups opened as " + mode);
+
+        reader->set_normalized_lookup(!normalized_at_open);
+        check(reader->normalized_index() == normalized_at_open, "index opened as " + mode + " stays " + mode);
+        check(finds_exact() && finds_folded() == normalized_at_open,
+            "lookups opened as " + mode + ", toggled while open");
+
+        reader->open(filepath);
+        check(finds_exact() && finds_folded() == !normalized_at_open,
+            "lookups reopened after toggling from " + mode);
+    }
+
+    // The writer rejects duplicates, so rename the entries in the file
+    // itself: dup/NN.bin all become dup/00.bin, more than one compact block
+    constexpr int kDuplicates = 40;
+
+    void write_duplicates(const std::string& filepath) {
+        auto name = [](int i) { return std::format("dup/{:02}.bin", i); };
+        ArchiveWriter writer;
+        for (int i = 0; i < kDuplicates; ++i) {
+            writer.add_file(name(i), std::format("entry {}", i));
+        }
+        auto bytes = writer.write_to_memory();
+        std::string archive(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        for (int i = 1; i < kDuplicates; ++i) {
+            archive.replace(archive.find(name(i)), name(i).size(), name(0));
+        }
+        std::ofstream(filepath, std::ios::binary).write(archive.data(), static_cast<std::streamsize>(archive.size()));
+    }
+
+    void check_duplicates(const std::string& filepath) {
+        std::string expected = std::format("entry {}", kDuplicates - 1);
+        for (int mode = 0; mode < 3; ++mode) {
+            ArchiveReader reader;
+            reader.set_compact_paths(mode == 1);
+            reader.set_normalized_lookup(mode == 2);
+            reader.open(filepath);
+            auto data = reader.read_raw("dup/00.bin");
+            check(std::string(reinterpret_cast<const char*>(data.data()), data.size()) == expected,
+                std::string("last duplicate wins, ") + (mode == 0 ? "hash" : mode == 1 ? "compact" : "normalized"));
+            check(reader.list_dir("dup").back() == reader.find("dup/00.bin"),
+                "sorted order keeps duplicates in table order");
+        }
+    }
+
+} // namespace
+
+int main() {
+    auto filepath = temp_path("rpfl_reader_mode_test");
+    write_archive(filepath);
+
+    check_toggle(filepath, false);
+    check_toggle(filepath, true);
+    check_normalized_toggle(filepath, false);
+    check_normalized_toggle(filepath, true);
+    write_duplicates(filepath);
+    check_duplicates(filepath);
+
+    std::filesystem::remove(filepath);
+    return finish();
+}
@@ -0,0 +1,74 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <filesystem>
+
+// rpfl_stats_test: the RPFL_ENABLE_STATS counters after a known sequence of
+// lookups, loads and evictions; reset_stats() zeroes the counts but not the
+// bytes_cached level. Built only with RPFL_ENABLE_STATS=ON
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    constexpr std::size_t kCacheThreshold = 4096;
+
+    bool counts(const ArchiveStats& s, std::uint64_t hits, std::uint64_t misses, std::uint64_t loads,
+        std::uint64_t fills, std::uint64_t evictions, std::uint64_t cached) {
+        return s.lookup_hits == hits && s.lookup_misses == misses && s.lookups == hits + misses
+            && s.loads == loads && s.cache_fills == fills && s.cache_evictions == evictions
+            && s.bytes_cached == cached;
+    }
+
+} // namespace
+
+int main() {
+    check(stats_enabled(), "built with RPFL_ENABLE_STATS");
+    auto filepath = temp_path("rpfl_stats_test");
+    {
+        ArchiveWriter writer;
+        writer.add_file("a.txt", std::string(100, 'a'));
+        writer.add_file("b.txt", std::string(200, 'b'));
+        writer.add_file("big.bin", std::string(kCacheThreshold * 4, 'c'));
+        writer.write(filepath);
+    }
+
+    {
+        ArchiveReader reader(filepath, kCacheThreshold, true, false);
+        reset_stats();
+        check(counts(stats(), 0, 0, 0, 0, 0, 0), "nothing counted after reset_stats()");
+
+        reader.find("a.txt");
+        reader.find("missing.txt");
+        reader.contains("b.txt");
+        reader.contains("b.txt/");
+        check(counts(stats(), 2, 2, 0, 0, 0, 0), "lookup hits and misses");
+
+        reader.get_file("a.txt").data();
+        reader.get_file("b.txt").data();
+        reader.get_file("b.txt").data();
+        check(counts(stats(), 5, 2, 2, 2, 0, 300), "cache fills, once per entry");
+
+        // Over the threshold, a view of the mapping: loaded, not cached
+        reader.get_file("big.bin").data();
+        auto chunk = reader.get_file("big.bin").read_chunk(10, 90);
+        ArchiveStats s = stats();
+        check(counts(s, 7, 2, 3, 2, 0, 300), "large entry isn't cached");
+        check(s.bytes_copied == 300 + chunk.size(), "bytes copied by fills and read_chunk");
+
+        reader.get_file("a.txt").release_cache();
+        reader.get_file("a.txt").release_cache();
+        check(counts(stats(), 9, 2, 3, 2, 1, 200), "one eviction per cached entry");
+
+        reset_stats();
+        check(counts(stats(), 0, 0, 0, 0, 0, 200), "reset_stats() leaves bytes_cached");
+
+        reader.get_file("a.txt").data();
+        check(counts(stats(), 1, 0, 1, 1, 0, 300), "reloading fills the cache again");
+        reader.close();
+        check(counts(stats(), 1, 0, 1, 1, 2, 0), "close() evicts what is cached");
+    }
+
+    std::filesystem::remove(filepath);
+    return finish();
+}
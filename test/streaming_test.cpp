@@ -0,0 +1,154 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+// rpfl_streaming_test: StreamingArchiveReader over write_to_memory() output,
+// fed in small uneven pieces, must hand out the entries ArchiveReader sees;
+// input cut short must throw instead of returning short data
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    constexpr std::size_t kChunkSize = 1000;
+
+    std::vector<std::byte> random_bytes(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::byte> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+        return data;
+    }
+
+    std::vector<std::byte> make_archive() {
+        ArchiveWriter writer;
+        writer.add_file("a.txt", "first entry");
+        writer.add_file("aligned.bin", random_bytes(10000, 1), 4096);
+        writer.add_file("empty.bin", std::vector<std::byte>{});
+        writer.add_file("skipped.bin", random_bytes(300000, 2), 16);
+        writer.add_file("chunked.bin", random_bytes(70000, 3), 64);
+        writer.add_file("last.txt", "read halfway, then left");
+        return writer.write_to_memory();
+    }
+
+    // At most 7 bytes per call, so no read lines up with the entries
+    StreamingArchiveReader::ReadFunction trickle(std::span<const std::byte> input) {
+        return [input, pos = std::size_t{ 0 }](std::span<std::byte> buffer) mutable {
+            std::size_t count = std::min({ buffer.size(), input.size() - pos, std::size_t{ 7 } });
+            std::copy_n(input.data() + pos, count, buffer.data());
+            pos += count;
+            return count;
+        };
+    }
+
+    template<typename Fn>
+    bool throws_format_error(Fn fn) {
+        try {
+            fn();
+        }
+        catch (const ArchiveFormatException&) {
+            return true;
+        }
+        return false;
+    }
+
+    bool same_bytes(std::span<const std::byte> a, std::span<const std::byte> b) {
+        return std::ranges::equal(a, b);
+    }
+
+} // namespace
+
+int main() {
+    auto bytes = make_archive();
+    auto filepath = temp_path("rpfl_streaming_test");
+    std::ofstream(filepath, std::ios::binary)
+        .write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    {
+        ArchiveReader expected(filepath);
+        StreamingArchiveReader reader(trickle(bytes), Endianness::Big, kChunkSize);
+        check(reader.identifier() == expected.identifier() && reader.version() == expected.version(),
+            "header");
+
+        bool same_table = reader.file_count() == expected.file_count();
+        for (const auto& entry : reader.entries()) {
+            const ArchiveFile* file = expected.find(entry.path);
+            same_table = same_table && file && file->offset() == entry.offset
+                && file->size() == entry.size && file->align() == entry.align;
+        }
+        check(same_table, "table matches ArchiveReader");
+
+        const auto* entry = reader.next();
+        check(entry && entry->path == "a.txt" && same_bytes(reader.read_all(), expected.read_raw("a.txt")),
+            "read_all");
+
+        entry = reader.next();
+        std::vector<std::byte> data;
+        bool bounded = true;
+        for (auto chunk = reader.read_chunk(); !chunk.empty(); chunk = reader.read_chunk()) {
+            bounded = bounded && chunk.size() <= kChunkSize;
+            data.insert(data.end(), chunk.begin(), chunk.end());
+        }
+        check(entry && entry->path == "aligned.bin" && entry->offset % 4096 == 0
+            && same_bytes(data, expected.read_raw("aligned.bin")), "read_chunk after alignment padding");
+        check(bounded, "chunks never exceed chunk_size");
+
+        entry = reader.next();
+        check(entry && entry->size == 0 && reader.remaining() == 0 && reader.read_chunk().empty(),
+            "zero-size entry");
+
+        entry = reader.next();
+        check(entry && entry->path == "skipped.bin", "entry to skip");
+        entry = reader.next();
+        check(entry && entry->path == "chunked.bin" && reader.position() == entry->offset,
+            "next() drops the unread entry and the padding");
+
+        data.clear();
+        std::vector<std::byte> buffer(777);
+        while (std::size_t count = reader.read(buffer)) {
+            data.insert(data.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+        check(same_bytes(data, expected.read_raw("chunked.bin")), "read() into a caller buffer");
+
+        entry = reader.next();
+        buffer.resize(entry ? entry->size / 2 : 0);
+        check(entry && entry->path == "last.txt" && reader.read(buffer) == buffer.size()
+            && reader.remaining() == entry->size - buffer.size(), "partial read of the last entry");
+        check(reader.next() == nullptr && reader.current() == nullptr && reader.next() == nullptr,
+            "no entry after the last");
+        check(reader.position() == bytes.size(), "whole input consumed");
+    }
+    {
+        std::istringstream stream(std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+        StreamingArchiveReader reader(stream);
+        std::size_t count = 0;
+        while (reader.next()) {
+            ++count;
+        }
+        check(count == reader.file_count() && reader.position() == bytes.size(), "istream input, all skipped");
+    }
+
+    std::span<const std::byte> all(bytes);
+    check(throws_format_error([&] { StreamingArchiveReader reader(trickle(all.first(20))); }),
+        "input cut in the header throws");
+    check(throws_format_error([&] {
+        StreamingArchiveReader reader(trickle(all.first(all.size() - 1)));
+        while (reader.next()) {
+            reader.read_all();
+        }
+    }), "input cut in the last entry throws");
+    check(throws_format_error([&] {
+        StreamingArchiveReader reader(trickle(all.first(all.size() / 2)));
+        while (reader.next()) {
+        }
+    }), "input cut in a skipped entry throws");
+
+    std::filesystem::remove(filepath);
+    return finish();
+}
@@ -65,6 +65,11 @@ int main() {
             std::cout << "File: " << file->path() << " Size: " << file->size() << "\n";
         }
 
+        // Sorted queries: whole directories (list_dir) or glob patterns, '*' stays inside one folder, '**' goes deeper
+        for (const auto* file : archive.glob("*.txt")) {
+            std::cout << "Text file: " << file->path() << "\n";
+        }
+
         // Freeing up all caches () 
         archive.release_all_caches();
         // We can do this manually if required, 
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Shared by the rpfl_*_test executables: checks print one line each and
+// count failures, main() returns finish()
+
+namespace RPFL::Test {
+
+    inline int failures = 0;
+
+    inline bool check(bool ok, std::string_view name) {
+        std::printf("%-4s %.*s\n", ok ? "ok" : "FAIL", static_cast<int>(name.size()), name.data());
+        failures += ok ? 0 : 1;
+        return ok;
+    }
+
+    inline int finish() {
+        if (failures != 0) {
+            std::printf("%d check(s) failed\n", failures);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Path in the temp directory that parallel runs (ctest -j, several build
+    // trees) don't share
+    inline std::string temp_path(std::string_view stem, std::string_view extension = ".gfs") {
+        static const unsigned suffix = std::random_device{}();
+        std::string name(stem);
+        name += '_';
+        name += std::to_string(suffix);
+        name += extension;
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+} // namespace RPFL::Test
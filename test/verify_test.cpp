@@ -0,0 +1,138 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+// rpfl_verify_test: ArchiveReader::verify() against the manifest written next
+// to or inside the archive, and a damaged, dropped or extra entry reported by
+// name
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    std::vector<std::byte> random_bytes(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::byte> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+        return data;
+    }
+
+    // Sizes and alignments that move the offsets across a few digit counts
+    ArchiveWriter make_writer() {
+        ArchiveWriter writer;
+        writer.add_file("a.bin", random_bytes(7, 1));
+        writer.add_file("dir/b.bin", random_bytes(9000, 2), 16);
+        writer.add_file("dir/empty.bin", std::vector<std::byte>{});
+        writer.add_file("dir/sub/c.bin", random_bytes(120000, 3), 4096);
+        writer.add_file("d.txt", "last entry");
+        return writer;
+    }
+
+    void flip_byte(const std::string& filepath, std::uint64_t offset) {
+        std::fstream file(filepath, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(static_cast<std::streamoff>(offset));
+        char byte = 0;
+        file.get(byte);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(~byte));
+    }
+
+} // namespace
+
+int main() {
+    auto filepath = temp_path("rpfl_verify_test");
+    auto sidecar = filepath + ".manifest";
+
+    ArchiveWriter writer = make_writer();
+    writer.set_manifest_mode(ManifestMode::Sidecar);
+    writer.write(filepath);
+    const ArchiveManifest manifest = ArchiveManifest::load(sidecar);
+    check(manifest.to_string() == writer.manifest().to_string() && manifest.size() == writer.file_count(),
+        "sidecar holds the manifest of the write");
+    check(ArchiveManifest::parse(manifest.to_string()).to_string() == manifest.to_string(),
+        "manifest text round trip");
+
+    {
+        ArchiveReader reader(filepath);
+        VerifyOptions options;
+        options.threads = 3;
+        options.manifest = &manifest;
+        VerifyReport report = reader.verify(options);
+        check(report.ok() && report.entries.size() == manifest.size(), "intact archive verifies");
+        check(report.to_manifest().to_string() == manifest.to_string(), "report rebuilds the written manifest");
+        bool offset_order = std::ranges::is_sorted(report.entries, {},
+            [](const VerifyReport::Entry& entry) { return entry.file->offset(); });
+        check(offset_order, "report entries in offset order");
+
+        ArchiveManifest partial;
+        for (const auto& entry : manifest.entries()) {
+            if (entry.path != "a.bin") {
+                partial.add(entry);
+            }
+        }
+        partial.add({ "gone.bin", 0, 1, 1, 0 });
+        options.manifest = &partial;
+        report = reader.verify(options);
+        check(report.unexpected == std::vector<std::string>{ "a.bin" }, "entry missing from the manifest is unexpected");
+        check(report.missing == std::vector<std::string>{ "gone.bin" }, "manifest entry not in the archive is missing");
+        check(report.mismatched.empty() && !report.ok(), "only those two are reported");
+    }
+
+    std::uint64_t damaged = manifest.find("dir/sub/c.bin")->offset + 5000;
+    flip_byte(filepath, damaged);
+    {
+        ArchiveReader reader(filepath);
+        VerifyOptions options;
+        options.manifest = &manifest;
+        VerifyReport report = reader.verify(options);
+        check(report.mismatched == std::vector<std::string>{ "dir/sub/c.bin" }, "corrupted entry is reported");
+        check(!report.ok() && report.missing.empty() && report.unexpected.empty(), "nothing else is reported");
+    }
+
+    // The manifest entry is sized from the plan before any CRC is known
+    writer.set_manifest_mode(ManifestMode::Embedded);
+    auto bytes = writer.write_to_memory();
+    std::string text = writer.manifest().to_string();
+    check(bytes.size() == writer.total_size(), "planned size includes the embedded manifest");
+    bool same_entries = writer.manifest().size() == manifest.size();
+    for (const auto& entry : manifest.entries()) {
+        // The extra table entry moves the offsets, nothing else changes
+        const ArchiveManifest::Entry* embedded = writer.manifest().find(entry.path);
+        same_entries = same_entries && embedded && embedded->size == entry.size && embedded->crc32c == entry.crc32c;
+    }
+    check(same_entries, "embedded manifest lists the entries of the sidecar one");
+    {
+        std::ofstream(filepath, std::ios::binary)
+            .write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        ArchiveReader reader(filepath);
+        const ArchiveFile* entry = reader.find(ArchiveManifest::kEmbeddedPath);
+        check(entry && entry->size() == text.size() && entry->offset() + entry->size() == bytes.size(),
+            "embedded manifest is the last entry, as big as written");
+        auto embedded = reader.embedded_manifest();
+        check(embedded && embedded->to_string() == text, "embedded manifest reads back");
+
+        VerifyOptions options;
+        options.manifest = &*embedded;
+        check(reader.verify(options).ok(), "archive verifies against its embedded manifest");
+    }
+
+    flip_byte(filepath, writer.manifest().find("dir/b.bin")->offset);
+    {
+        ArchiveReader reader(filepath);
+        auto embedded = reader.embedded_manifest();
+        VerifyOptions options;
+        options.manifest = embedded ? &*embedded : nullptr;
+        check(embedded && reader.verify(options).mismatched == std::vector<std::string>{ "dir/b.bin" },
+            "corrupted entry is reported against the embedded manifest");
+    }
+
+    std::filesystem::remove(filepath);
+    std::filesystem::remove(sidecar);
+    return finish();
+}
@@ -0,0 +1,217 @@
+#include "RPFL.h"
+#include "test_common.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// rpfl_writer_output_test: every ArchiveWriter output (file descriptor,
+// stream, file in each OutputMode) must carry the bytes of write_to_memory(),
+// streamed and source entries included, and an entry producing other than
+// its declared size must fail the write
+
+namespace {
+
+    using namespace RPFL;
+    using namespace RPFL::Test;
+
+    std::vector<std::byte> random_bytes(std::size_t size, std::uint64_t seed) {
+        std::mt19937_64 random(seed);
+        std::vector<std::byte> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<std::byte>(random());
+        }
+        return data;
+    }
+
+    void write_file(const std::filesystem::path& filepath, std::span<const std::byte> data) {
+        std::ofstream(filepath, std::ios::binary)
+            .write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::string read_file(const std::filesystem::path& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    }
+
+    // size bytes from data, handed to the sink in three uneven pieces
+    ArchiveWriter::EntrySource pieces(std::vector<std::byte> data, std::size_t size) {
+        return [data = std::move(data), size](const ArchiveWriter::ChunkSink& sink) {
+            std::span<const std::byte> all(data.data(), size);
+            sink(all.first(size / 3));
+            sink(all.subspan(size / 3, size / 3));
+            sink(all.subspan(2 * (size / 3)));
+        };
+    }
+
+    // The archive written through a pipe, read back on this thread
+    std::string write_through_pipe(ArchiveWriter& writer) {
+        int fds[2];
+#ifdef _WIN32
+        bool opened = ::_pipe(fds, 1 << 16, _O_BINARY) == 0;
+#else
+        bool opened = ::pipe(fds) == 0;
+#endif
+        if (!opened) {
+            check(false, "pipe()");
+            return {};
+        }
+
+        bool failed = false;
+        std::thread producer([&] {
+            try {
+                writer.write(fds[1]);
+            }
+            catch (const std::exception&) {
+                failed = true;
+            }
+#ifdef _WIN32
+            ::_close(fds[1]);
+#else
+            ::close(fds[1]);
+#endif
+        });
+
+        std::string received;
+        char buffer[4096];
+        for (;;) {
+#ifdef _WIN32
+            int count = ::_read(fds[0], buffer, sizeof(buffer));
+#else
+            ssize_t count = ::read(fds[0], buffer, sizeof(buffer));
+#endif
+            if (count <= 0) {
+                break;
+            }
+            received.append(buffer, static_cast<std::size_t>(count));
+        }
+        producer.join();
+#ifdef _WIN32
+        ::_close(fds[0]);
+#else
+        ::close(fds[0]);
+#endif
+        check(!failed, "write(fd) doesn't throw");
+        return received;
+    }
+
+    // Past the direct buffer and the drop window, ending mid-page; in the
+    // temp directory (often tmpfs, where O_DIRECT falls back) and the
+    // working directory
+    void check_output_modes() {
+        ArchiveWriter writer;
+        writer.add_file("small.txt", "unaligned start");
+        writer.add_file("big.bin", random_bytes(9 * 1024 * 1024 + 123, 5), 4096);
+        writer.add_file("odd.bin", random_bytes(777, 6), 16);
+        auto expected = writer.write_to_memory();
+        std::string expected_text(reinterpret_cast<const char*>(expected.data()), expected.size());
+        check(expected.size() % 4096 != 0, "archive size is not a multiple of 4096");
+
+        ArchiveWriter tiny;
+        tiny.add_file("only.txt", "smaller than one page");
+        auto tiny_expected = tiny.write_to_memory();
+        std::string tiny_text(reinterpret_cast<const char*>(tiny_expected.data()), tiny_expected.size());
+
+        for (const auto& dir : { std::filesystem::temp_directory_path(), std::filesystem::current_path() }) {
+            auto filepath = (dir / std::filesystem::path(temp_path("rpfl_writer_output_mode")).filename()).string();
+            for (OutputMode mode : { OutputMode::Direct, OutputMode::DropCache }) {
+                std::string name = std::string(mode == OutputMode::Direct ? "Direct" : "DropCache")
+                    + " in " + dir.string();
+                writer.set_output_mode(mode);
+                writer.write(filepath);
+                check(read_file(filepath) == expected_text, name + " matches write_to_memory()");
+                tiny.set_output_mode(mode);
+                tiny.write(filepath);
+                check(read_file(filepath) == tiny_text, name + ", archive under one page, matches");
+            }
+            std::filesystem::remove(filepath);
+        }
+    }
+
+    bool write_throws(ArchiveWriter& writer) {
+        try {
+            writer.write_to_memory();
+        }
+        catch (const ArchiveException&) {
+            return true;
+        }
+        return false;
+    }
+
+} // namespace
+
+int main() {
+    auto streamed_path = std::filesystem::path(temp_path("rpfl_writer_output_streamed", ".bin"));
+    auto archive_path = temp_path("rpfl_writer_output_test");
+    auto streamed = random_bytes(200000, 1);
+    write_file(streamed_path, streamed);
+
+    ArchiveWriter writer;
+    writer.set_stream_chunk_size(4096);
+    writer.add_file("header.txt", "small entry, gathered with the table");
+    check(writer.add_file_streamed(streamed_path, "streamed/big.bin", 4096), "add_file_streamed");
+    writer.add_file_source("source.bin", 10000, pieces(random_bytes(10000, 2), 10000), 64);
+    writer.add_file("tail.txt", "last");
+
+    auto expected = writer.write_to_memory();
+    std::string expected_text(reinterpret_cast<const char*>(expected.data()), expected.size());
+    check(expected.size() == writer.total_size(), "write_to_memory() is total_size() bytes");
+    {
+        ArchiveReader reader;
+        check(writer.write_to_memory() == expected, "sources run again on every write");
+        write_file(archive_path, expected);
+        reader.open(archive_path);
+        auto data = reader.read_raw("streamed/big.bin");
+        check(data.size() == streamed.size() && std::memcmp(data.data(), streamed.data(), data.size()) == 0,
+            "streamed entry holds the file");
+    }
+
+    check(write_through_pipe(writer) == expected_text, "write(fd) through a pipe matches write_to_memory()");
+    std::ostringstream stream;
+    writer.write(stream);
+    check(stream.str() == expected_text, "write(ostream) matches write_to_memory()");
+    writer.write(archive_path);
+    check(read_file(archive_path) == expected_text, "write(filepath) matches write_to_memory()");
+
+    check(!writer.add_file_streamed(streamed_path.string() + ".missing"), "missing file isn't added");
+    bool null_source = false;
+    try {
+        writer.add_file_source("null.bin", 1, nullptr);
+    }
+    catch (const ArchiveException&) {
+        null_source = true;
+    }
+    check(null_source && !writer.contains("null.bin"), "entry without a source is rejected");
+
+    {
+        ArchiveWriter bad;
+        bad.add_file_source("short.bin", 100, pieces(random_bytes(100, 3), 99));
+        check(write_throws(bad), "source producing fewer bytes than declared fails the write");
+    }
+    {
+        ArchiveWriter bad;
+        bad.add_file_source("long.bin", 100, pieces(random_bytes(101, 4), 101));
+        check(write_throws(bad), "source producing more bytes than declared fails the write");
+    }
+    {
+        // Declared by stat at add time, shorter by write time
+        write_file(streamed_path, std::span(streamed).first(1000));
+        check(write_throws(writer), "streamed file that shrank fails the write");
+    }
+
+    check_output_modes();
+
+    std::filesystem::remove(streamed_path);
+    std::filesystem::remove(archive_path);
+    return finish();
+}